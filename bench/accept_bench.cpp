@@ -0,0 +1,141 @@
+/*
+ * Connection rate benchmark. Every client repeatedly opens a connection,
+ * sends one GET request, waits for the first bytes of the response and
+ * closes the connection again, so each iteration is one connection the
+ * server had to accept and serve.
+ *
+ * Usage: accept_bench <port> <path> [clients] [seconds]
+ */
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using boost::asio::ip::tcp;
+
+struct Stats {
+  std::uint64_t connections{0};
+  std::uint64_t errors{0};
+  std::vector<double> latencies_us{};
+};
+
+class Client: public std::enable_shared_from_this<Client> {
+public:
+  Client(boost::asio::io_context& io_context, const tcp::endpoint& endpoint,
+         const std::string& request, Clock::time_point deadline, Stats& stats)
+      : _io_context(io_context), _socket(io_context), _endpoint(endpoint), _request(request),
+        _deadline(deadline), _stats(stats) {}
+
+  void start() {
+    if (Clock::now() >= _deadline) {
+      return;
+    }
+    _socket = tcp::socket(_io_context);
+    _started_at = Clock::now();
+    _socket.async_connect(_endpoint, [self = shared_from_this()](boost::system::error_code ec) {
+      if (ec) {
+        self->fail();
+        return;
+      }
+      self->send();
+    });
+  }
+
+private:
+  void send() {
+    boost::asio::async_write(
+        _socket, boost::asio::buffer(_request),
+        [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+          if (ec) {
+            self->fail();
+            return;
+          }
+          self->read();
+        });
+  }
+
+  void read() {
+    _socket.async_read_some(
+        boost::asio::buffer(_response),
+        [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+          if (ec) {
+            self->fail();
+            return;
+          }
+          ++self->_stats.connections;
+          self->_stats.latencies_us.push_back(
+              std::chrono::duration<double, std::micro>(Clock::now() - self->_started_at)
+                  .count());
+          self->close();
+          self->start();
+        });
+  }
+
+  void fail() {
+    ++_stats.errors;
+    close();
+    start();
+  }
+
+  void close() {
+    boost::system::error_code ec;
+    _socket.close(ec);
+  }
+
+  boost::asio::io_context& _io_context;
+  tcp::socket _socket;
+  tcp::endpoint _endpoint;
+  const std::string& _request;
+  Clock::time_point _deadline;
+  Clock::time_point _started_at{};
+  Stats& _stats;
+  std::array<char, 4096> _response{};
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <port> <path> [clients] [seconds]" << std::endl;
+    return 1;
+  }
+  auto port = static_cast<std::uint16_t>(std::stoi(argv[1]));
+  std::string path{argv[2]};
+  std::uint32_t clients = argc > 3 ? std::stoul(argv[3]) : 64;
+  std::uint32_t seconds = argc > 4 ? std::stoul(argv[4]) : 5;
+
+  std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  tcp::endpoint endpoint{boost::asio::ip::address_v4::loopback(), port};
+
+  boost::asio::io_context io_context{1};
+  Stats stats{};
+  auto start = Clock::now();
+  auto deadline = start + std::chrono::seconds(seconds);
+  for (std::uint32_t i = 0; i < clients; ++i) {
+    std::make_shared<Client>(io_context, endpoint, request, deadline, stats)->start();
+  }
+  io_context.run();
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::sort(stats.latencies_us.begin(), stats.latencies_us.end());
+  auto percentile = [&stats](double p) {
+    if (stats.latencies_us.empty()) {
+      return 0.0;
+    }
+    return stats.latencies_us[static_cast<std::size_t>(p * (stats.latencies_us.size() - 1))];
+  };
+
+  std::cout << "clients:     " << clients << ", duration: " << elapsed << " s\n"
+            << "connections: " << stats.connections << " (" << stats.connections / elapsed
+            << " conn/s), errors: " << stats.errors << "\n"
+            << "latency:     p50 " << percentile(0.5) << " us, p99 " << percentile(0.99)
+            << " us (connect to first response byte)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * HTTP load generator used to compare server builds (e.g. the epoll and
+ * io_uring backends). Every connection sends keep-alive GET requests for
+ * one path and waits for each response before sending the next one.
+ *
+ * Usage: http_bench <port> <path> [connections] [seconds]
+ */
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using boost::asio::ip::tcp;
+
+struct Stats {
+  std::uint64_t requests{0};
+  std::uint64_t bytes{0};
+  std::uint64_t errors{0};
+  std::vector<double> latencies_us{};
+};
+
+class Client: public std::enable_shared_from_this<Client> {
+public:
+  Client(boost::asio::io_context& io_context, const tcp::endpoint& endpoint,
+         const std::string& request, Clock::time_point deadline, Stats& stats)
+      : _socket(io_context), _endpoint(endpoint), _request(request), _deadline(deadline),
+        _stats(stats) {}
+
+  void start() {
+    _socket.async_connect(_endpoint, [self = shared_from_this()](boost::system::error_code ec) {
+      if (ec) {
+        ++self->_stats.errors;
+        return;
+      }
+      self->_socket.set_option(tcp::no_delay(true));
+      self->send();
+    });
+  }
+
+private:
+  void send() {
+    if (Clock::now() >= _deadline) {
+      return;
+    }
+    _sent_at = Clock::now();
+    boost::asio::async_write(
+        _socket, boost::asio::buffer(_request),
+        [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+          if (ec) {
+            ++self->_stats.errors;
+            return;
+          }
+          self->read_header();
+        });
+  }
+
+  void read_header() {
+    boost::asio::async_read_until(
+        _socket, _buffer, "\r\n\r\n",
+        [self = shared_from_this()](boost::system::error_code ec, std::size_t header_size) {
+          if (ec) {
+            ++self->_stats.errors;
+            return;
+          }
+          std::string header{static_cast<const char*>(self->_buffer.data().data()), header_size};
+          std::size_t content_length = 0;
+          auto pos = header.find("Content-Length: ");
+          if (pos != std::string::npos) {
+            content_length = std::stoull(header.substr(pos + 16));
+          }
+          self->_buffer.consume(header_size);
+          self->_stats.bytes += header_size;
+          self->read_body(content_length);
+        });
+  }
+
+  void read_body(std::size_t remaining) {
+    auto buffered = std::min(remaining, _buffer.size());
+    _buffer.consume(buffered);
+    _stats.bytes += buffered;
+    remaining -= buffered;
+    if (remaining == 0) {
+      finish_request();
+      return;
+    }
+    _body.resize(std::min<std::size_t>(remaining, 256 * 1024));
+    _socket.async_read_some(
+        boost::asio::buffer(_body),
+        [self = shared_from_this(), remaining](boost::system::error_code ec, std::size_t size) {
+          if (ec) {
+            ++self->_stats.errors;
+            return;
+          }
+          self->_stats.bytes += size;
+          self->read_body(remaining - size);
+        });
+  }
+
+  void finish_request() {
+    ++_stats.requests;
+    _stats.latencies_us.push_back(
+        std::chrono::duration<double, std::micro>(Clock::now() - _sent_at).count());
+    send();
+  }
+
+  tcp::socket _socket;
+  tcp::endpoint _endpoint;
+  const std::string& _request;
+  Clock::time_point _deadline;
+  Clock::time_point _sent_at{};
+  Stats& _stats;
+  boost::asio::streambuf _buffer{};
+  std::vector<char> _body{};
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <port> <path> [connections] [seconds]" << std::endl;
+    return 1;
+  }
+  auto port = static_cast<std::uint16_t>(std::stoi(argv[1]));
+  std::string path{argv[2]};
+  std::uint32_t connections = argc > 3 ? std::stoul(argv[3]) : 16;
+  std::uint32_t seconds = argc > 4 ? std::stoul(argv[4]) : 5;
+
+  std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  tcp::endpoint endpoint{boost::asio::ip::address_v4::loopback(), port};
+
+  boost::asio::io_context io_context{1};
+  Stats stats{};
+  auto start = Clock::now();
+  auto deadline = start + std::chrono::seconds(seconds);
+  for (std::uint32_t i = 0; i < connections; ++i) {
+    std::make_shared<Client>(io_context, endpoint, request, deadline, stats)->start();
+  }
+  io_context.run();
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::sort(stats.latencies_us.begin(), stats.latencies_us.end());
+  auto percentile = [&stats](double p) {
+    if (stats.latencies_us.empty()) {
+      return 0.0;
+    }
+    return stats.latencies_us[static_cast<std::size_t>(p * (stats.latencies_us.size() - 1))];
+  };
+
+  std::cout << "connections: " << connections << ", duration: " << elapsed << " s\n"
+            << "requests:    " << stats.requests << " (" << stats.requests / elapsed
+            << " req/s), errors: " << stats.errors << "\n"
+            << "throughput:  " << stats.bytes / elapsed / (1024 * 1024) << " MiB/s\n"
+            << "latency:     p50 " << percentile(0.5) << " us, p99 " << percentile(0.99)
+            << " us" << std::endl;
+  return 0;
+}
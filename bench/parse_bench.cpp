@@ -0,0 +1,222 @@
+/*
+ * Request header parsing benchmark. Compares, on the same requests:
+ *  - framing: finding the end of the header with find("\r\n\r\n") and
+ *    scanning its lines again for Content-Length and Transfer-Encoding,
+ *    as the connection did before RequestParser;
+ *  - legacy: the get_line/split_line/split_head parse of RequestHeader
+ *    that copied every token into strings;
+ *  - header: RequestHeader::parse() as it is now, on top of RequestParser;
+ *  - parser: RequestParser alone, as the connection uses it.
+ * Each request is also fed in segments of a few bytes, as a slow client
+ * sends it: the framing scan starts over with every segment while the
+ * parser resumes where it stopped. The parser is measured with every
+ * character scanning kernel the CPU supports.
+ *
+ * Build with -DBUILD_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release.
+ * Usage: parse_bench [iterations] [segment size]
+ */
+#include "../include/char_scan.hpp"
+#include "../include/request_header.hpp"
+#include "../include/request_parser.hpp"
+#include "../include/utils.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using web_server::message::DataView;
+using web_server::message::RequestHeader;
+using web_server::message::RequestParser;
+using web_server::utils::CharScanner;
+using web_server::utils::ScanLevel;
+
+const std::vector<std::string> REQUESTS{
+    "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n",
+    "GET /assets/app.js?v=3 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:120.0) Gecko/20100101 Firefox/120.0\r\n"
+    "Accept: */*\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Referer: https://www.example.com/\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: session=0123456789abcdef0123456789abcdef; theme=dark\r\n"
+    "Sec-Fetch-Dest: script\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "If-None-Match: \"5f3a-1700000000\"\r\n"
+    "\r\n",
+    "POST /api/items HTTP/1.1\r\n"
+    "Host: localhost:8080\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 27\r\n"
+    "\r\n",
+    "GET /dashboard HTTP/1.1\r\n"
+    "Host: app.example.com\r\n"
+    "Cookie: _ga=GA1.2.1234567890.1700000000; _gid=GA1.2.987654321.1700000000; "
+    "session=eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9.eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6IkpvaG4g"
+    "RG9lIiwiaWF0IjoxNTE2MjM5MDIyLCJyb2xlcyI6WyJhZG1pbiIsImVkaXRvciIsInZpZXdlciJdfQ.SflKxwRJ"
+    "SMeKKF2QT4fwpMeJf36POk6yJV_adQssw5c; preferences=%7B%22theme%22%3A%22dark%22%2C%22lang"
+    "%22%3A%22en%22%2C%22tz%22%3A%22Europe%2FBerlin%22%7D; csrftoken=0123456789abcdef0123456"
+    "789abcdef0123456789abcdef0123456789abcdef\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,*/*;q=0.8\r\n"
+    "\r\n",
+};
+
+const char* level_name(ScanLevel level) {
+  switch (level) {
+  case ScanLevel::scalar:
+    return "scalar";
+  case ScanLevel::sse2:
+    return "sse2";
+  case ScanLevel::avx2:
+    return "avx2";
+  }
+  return "";
+}
+
+// RequestHeader::parse before RequestParser replaced it.
+std::size_t legacy_parse(std::string_view data) {
+  int start = 0;
+  std::string_view line;
+  if (web_server::utils::get_line(data, line, &start) != 0) {
+    return 0;
+  }
+  std::vector<std::string_view> words;
+  web_server::utils::split_line(line, words);
+  std::string path{words.size() > 1 ? words[1] : ""};
+  std::string version{words.size() > 2 ? words[2] : ""};
+  std::unordered_map<std::string, std::string> headers{};
+  while (web_server::utils::get_line(data, line, &start) != -1) {
+    std::string_view key, value;
+    web_server::utils::split_head(line, key, value);
+    headers.emplace(std::string(key), std::string(value));
+  }
+  return start + path.size() + version.size() + headers.size();
+}
+
+// The framing scan of the connection before RequestParser replaced it.
+std::size_t frame(std::string_view data) {
+  auto header_end = data.find("\r\n\r\n");
+  if (header_end == std::string_view::npos) {
+    return 0;
+  }
+  std::uint64_t length = 0;
+  bool chunked = false;
+  // Skip the request line.
+  auto position = web_server::utils::find_crlf(data, 0);
+  while (position < header_end) {
+    position += 2;
+    auto end = web_server::utils::find_crlf(data, position);
+    auto line = data.substr(position, end - position);
+    position = end;
+
+    auto colon = line.find(':');
+    if (colon == std::string_view::npos) {
+      continue;
+    }
+    auto name = line.substr(0, colon);
+    auto value = web_server::utils::trim(line.substr(colon + 1));
+    if (web_server::utils::equals_ignore_case(name, "Content-Length")) {
+      std::from_chars(value.data(), value.data() + value.size(), length);
+    } else if (web_server::utils::equals_ignore_case(name, "Transfer-Encoding")) {
+      chunked = value.ends_with("chunked");
+    }
+  }
+  return header_end + 4 + (chunked ? 0 : length);
+}
+
+// Runs parse on every request iterations times; returns ns per request.
+double measure(std::size_t iterations,
+               const std::function<std::size_t(const std::string&)>& parse) {
+  std::size_t checksum = 0;
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < iterations; ++i) {
+    for (const auto& request : REQUESTS) {
+      checksum += parse(request);
+    }
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  if (checksum == 0) {
+    std::cerr << "Nothing was parsed" << std::endl;
+  }
+  return elapsed / static_cast<double>(iterations * REQUESTS.size());
+}
+
+void report(const std::string& name, double ns, std::size_t bytes) {
+  std::cout << name << ns << " ns/request, " << static_cast<double>(bytes) / ns * 1000.0
+            << " MB/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200000;
+  std::size_t segment = argc > 2 ? std::stoul(argv[2]) : 16;
+  std::size_t bytes = 0;
+  for (const auto& request : REQUESTS) {
+    bytes += request.size();
+  }
+  bytes /= REQUESTS.size();
+
+  RequestParser parser{};
+  std::cout << "requests: " << REQUESTS.size() << " x " << iterations << ", " << bytes
+            << " bytes on average\n"
+            << "complete header:" << std::endl;
+  report("  framing:  ", measure(iterations, [](const std::string& request) {
+           return frame(request);
+         }),
+         bytes);
+  report("  legacy:   ", measure(iterations, legacy_parse), bytes);
+  report("  header:   ", measure(iterations, [](const std::string& request) {
+           RequestHeader header{};
+           return static_cast<std::size_t>(header.parse(DataView(
+               reinterpret_cast<const std::uint8_t*>(request.data()), request.size(), 0)));
+         }),
+         bytes);
+  auto level = CharScanner::active().level;
+  for (auto scan_level : {ScanLevel::scalar, ScanLevel::sse2, ScanLevel::avx2}) {
+    if (!CharScanner::use(scan_level)) {
+      continue;
+    }
+    report(std::string("  parser (") + level_name(scan_level) + "): ",
+           measure(iterations,
+                   [&parser](const std::string& request) {
+                     parser.reset();
+                     parser.parse(request);
+                     return parser.header_size();
+                   }),
+           bytes);
+  }
+  CharScanner::use(level);
+
+  std::cout << "in segments of " << segment << " bytes:" << std::endl;
+  report("  framing:  ", measure(iterations, [segment](const std::string& request) {
+           std::size_t size = 0;
+           for (std::size_t end = segment; size == 0; end += segment) {
+             size = frame(std::string_view(request).substr(0, end));
+           }
+           return size;
+         }),
+         bytes);
+  report("  parser:   ", measure(iterations, [&parser, segment](const std::string& request) {
+           parser.reset();
+           for (std::size_t end = segment;
+                parser.parse(std::string_view(request).substr(0, end)) ==
+                RequestParser::Status::incomplete;
+                end += segment) {
+           }
+           return parser.header_size();
+         }),
+         bytes);
+  return 0;
+}
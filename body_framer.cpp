@@ -0,0 +1,231 @@
+#include "include/body_framer.hpp"
+#include "include/utils.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace web_server {
+namespace message {
+
+namespace {
+
+bool parse_length(std::string_view value, std::uint64_t& length) {
+  if (value.empty()) {
+    return false;
+  }
+  length = 0;
+  for (char c : value) {
+    if (c < '0' || c > '9' || length > (std::numeric_limits<std::uint64_t>::max() - 9) / 10) {
+      return false;
+    }
+    length = length * 10 + static_cast<std::uint64_t>(c - '0');
+  }
+  return true;
+}
+
+int hex_digit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+} // namespace
+
+void BodyFramer::begin() {
+  _framing = Framing::none;
+  _state = State::done;
+  _remaining_length = 0;
+  _chunk_size = 0;
+  _line_size = 0;
+  _trailer_size = 0;
+  _trailer_line_size = 0;
+  _has_chunk_size = false;
+  _has_length = false;
+  _has_transfer_encoding = false;
+  _chunked = false;
+}
+
+bool BodyFramer::add_field(std::string_view key, std::string_view value) {
+  value = utils::trim(value);
+  if (utils::equals_ignore_case(key, "Content-Length")) {
+    std::uint64_t length = 0;
+    if (!parse_length(value, length) || (_has_length && length != _remaining_length)) {
+      return false;
+    }
+    _has_length = true;
+    _remaining_length = length;
+  } else if (utils::equals_ignore_case(key, "Transfer-Encoding")) {
+    // Codings apply in order; the body is only delimited if chunked is last.
+    _has_transfer_encoding = true;
+    auto comma = value.rfind(',');
+    auto last = utils::trim(comma == std::string_view::npos ? value : value.substr(comma + 1));
+    _chunked = utils::equals_ignore_case(last, "chunked");
+  }
+  return true;
+}
+
+bool BodyFramer::finish() {
+  if (_has_transfer_encoding) {
+    if (!_chunked || _has_length) {
+      return false;
+    }
+    _framing = Framing::chunked;
+    _state = State::chunk_size;
+  } else if (_has_length && _remaining_length > 0) {
+    _framing = Framing::length;
+    _state = State::length;
+  }
+  return true;
+}
+
+bool BodyFramer::start(const RequestParser& parser) {
+  begin();
+  for (std::size_t i = 0; i < parser.field_count(); ++i) {
+    auto field = parser.field(i);
+    if (!add_field(field.name, field.value)) {
+      return false;
+    }
+  }
+  return finish();
+}
+
+BodyFramer::Status BodyFramer::decode(std::string_view data, std::size_t& consumed,
+                                      std::vector<std::string_view>& body) {
+  consumed = 0;
+  if (_state == State::done) {
+    return Status::complete;
+  }
+  if (_framing == Framing::chunked) {
+    return decode_chunked(data, consumed, body);
+  }
+
+  auto size = static_cast<std::size_t>(std::min<std::uint64_t>(_remaining_length, data.size()));
+  if (size > 0) {
+    body.push_back(data.substr(0, size));
+  }
+  consumed = size;
+  _remaining_length -= size;
+  if (_remaining_length == 0) {
+    _state = State::done;
+    return Status::complete;
+  }
+  return Status::incomplete;
+}
+
+BodyFramer::Status BodyFramer::decode_chunked(std::string_view data, std::size_t& consumed,
+                                              std::vector<std::string_view>& body) {
+  std::size_t i = 0;
+  while (i < data.size()) {
+    char c = data[i];
+    switch (_state) {
+    case State::chunk_size: {
+      auto digit = hex_digit(c);
+      if (digit >= 0) {
+        if (_chunk_size > (std::numeric_limits<std::uint64_t>::max() >> 4)) {
+          return Status::error;
+        }
+        _chunk_size = (_chunk_size << 4) | static_cast<std::uint64_t>(digit);
+        _has_chunk_size = true;
+      } else if (!_has_chunk_size) {
+        return Status::error;
+      } else if (c == '\r') {
+        _state = State::chunk_size_lf;
+      } else if (c == ';' || c == ' ' || c == '\t') {
+        _state = State::chunk_extension;
+      } else {
+        return Status::error;
+      }
+      ++i;
+      break;
+    }
+    case State::chunk_extension:
+      if (c == '\r') {
+        _state = State::chunk_size_lf;
+      }
+      ++i;
+      break;
+    case State::chunk_size_lf:
+      if (c != '\n') {
+        return Status::error;
+      }
+      ++i;
+      _line_size = 0;
+      _has_chunk_size = false;
+      if (_chunk_size == 0) {
+        _state = State::trailer;
+        _trailer_line_size = 0;
+      } else {
+        _state = State::chunk_data;
+      }
+      continue;
+    case State::chunk_data: {
+      auto size =
+          static_cast<std::size_t>(std::min<std::uint64_t>(_chunk_size, data.size() - i));
+      body.push_back(data.substr(i, size));
+      i += size;
+      _chunk_size -= size;
+      if (_chunk_size == 0) {
+        _state = State::chunk_data_cr;
+      }
+      continue;
+    }
+    case State::chunk_data_cr:
+      if (c != '\r') {
+        return Status::error;
+      }
+      _state = State::chunk_data_lf;
+      ++i;
+      continue;
+    case State::chunk_data_lf:
+      if (c != '\n') {
+        return Status::error;
+      }
+      _state = State::chunk_size;
+      ++i;
+      continue;
+    case State::trailer:
+      if (c == '\r') {
+        _state = State::trailer_lf;
+      } else {
+        ++_trailer_line_size;
+      }
+      ++i;
+      if (++_trailer_size > MAX_TRAILER_SIZE) {
+        return Status::error;
+      }
+      continue;
+    case State::trailer_lf:
+      if (c != '\n') {
+        return Status::error;
+      }
+      ++i;
+      if (_trailer_line_size == 0) {
+        _state = State::done;
+        consumed = i;
+        return Status::complete;
+      }
+      _trailer_line_size = 0;
+      _state = State::trailer;
+      continue;
+    case State::length:
+    case State::done:
+      return Status::error;
+    }
+    // Only the chunk size line gets here.
+    if (++_line_size > MAX_LINE_SIZE) {
+      return Status::error;
+    }
+  }
+  consumed = i;
+  return Status::incomplete;
+}
+
+} // namespace message
+} // namespace web_server
@@ -0,0 +1,119 @@
+#include "include/byte_range.hpp"
+#include "include/utils.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace web_server {
+namespace message {
+
+namespace {
+
+bool parse_number(std::string_view value, std::uint64_t& number) {
+  if (value.empty()) {
+    return false;
+  }
+  number = 0;
+  for (char c : value) {
+    if (c < '0' || c > '9' || number > (std::numeric_limits<std::uint64_t>::max() - 9) / 10) {
+      return false;
+    }
+    number = number * 10 + static_cast<std::uint64_t>(c - '0');
+  }
+  return true;
+}
+
+void merge_overlapping(std::vector<ByteRange>& ranges) {
+  auto sorted = ranges;
+  std::sort(sorted.begin(), sorted.end(),
+            [](const ByteRange& a, const ByteRange& b) { return a.first < b.first; });
+  bool overlap = false;
+  for (std::size_t i = 1; i < sorted.size() && !overlap; ++i) {
+    overlap = sorted[i].first <= sorted[i - 1].last;
+  }
+  if (!overlap) {
+    return;
+  }
+
+  ranges.clear();
+  for (const auto& range : sorted) {
+    if (!ranges.empty() && range.first <= ranges.back().last) {
+      ranges.back().last = std::max(ranges.back().last, range.last);
+    } else {
+      ranges.push_back(range);
+    }
+  }
+}
+
+} // namespace
+
+RangeStatus parse_byte_ranges(std::string_view value, std::uint64_t size,
+                              std::vector<ByteRange>& ranges) {
+  ranges.clear();
+  value = utils::trim(value);
+  auto equals = value.find('=');
+  if (equals == std::string_view::npos) {
+    return RangeStatus::ignored;
+  }
+  auto unit = utils::trim(value.substr(0, equals));
+  if (!utils::equals_ignore_case(unit, "bytes")) {
+    return RangeStatus::ignored;
+  }
+
+  std::size_t count = 0;
+  auto specs = value.substr(equals + 1);
+  while (true) {
+    auto comma = specs.find(',');
+    auto spec = utils::trim(specs.substr(0, comma));
+    if (!spec.empty()) {
+      if (++count > MAX_BYTE_RANGES) {
+        ranges.clear();
+        return RangeStatus::ignored;
+      }
+      auto dash = spec.find('-');
+      if (dash == std::string_view::npos) {
+        ranges.clear();
+        return RangeStatus::ignored;
+      }
+      auto first_part = spec.substr(0, dash);
+      auto last_part = spec.substr(dash + 1);
+      std::uint64_t first = 0;
+      std::uint64_t last = 0;
+      if (first_part.empty()) {
+        // Suffix range: the final last_part bytes.
+        if (!parse_number(last_part, last)) {
+          ranges.clear();
+          return RangeStatus::ignored;
+        }
+        if (last > 0 && size > 0) {
+          ranges.push_back({size - std::min(last, size), size - 1});
+        }
+      } else {
+        if (!parse_number(first_part, first) ||
+            (!last_part.empty() && (!parse_number(last_part, last) || last < first))) {
+          ranges.clear();
+          return RangeStatus::ignored;
+        }
+        if (first < size) {
+          ranges.push_back({first, last_part.empty() ? size - 1 : std::min(last, size - 1)});
+        }
+      }
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    specs.remove_prefix(comma + 1);
+  }
+
+  if (count == 0) {
+    return RangeStatus::ignored;
+  }
+  if (ranges.empty()) {
+    return RangeStatus::unsatisfiable;
+  }
+  merge_overlapping(ranges);
+  return RangeStatus::satisfiable;
+}
+
+} // namespace message
+} // namespace web_server
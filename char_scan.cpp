@@ -0,0 +1,276 @@
+#include "include/char_scan.hpp"
+
+#include <atomic>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace web_server {
+namespace utils {
+
+namespace {
+
+std::size_t scalar_skip(std::string_view data, std::size_t i, CharClass char_class) {
+  while (i < data.size() && is(data[i], char_class)) {
+    ++i;
+  }
+  return i;
+}
+
+std::size_t scalar_skip_token(std::string_view data, std::size_t from) {
+  return scalar_skip(data, from, TOKEN);
+}
+
+std::size_t scalar_skip_target(std::string_view data, std::size_t from) {
+  return scalar_skip(data, from, TARGET);
+}
+
+std::size_t scalar_skip_value(std::string_view data, std::size_t from) {
+  return scalar_skip(data, from, VALUE);
+}
+
+std::size_t scalar_find_crlf(std::string_view data, std::size_t from) {
+  for (auto i = from; i + 1 < data.size(); ++i) {
+    if (data[i] == '\r' && data[i + 1] == '\n') {
+      return i;
+    }
+  }
+  return std::string_view::npos;
+}
+
+constexpr CharScanner SCALAR{ScanLevel::scalar, scalar_skip_token, scalar_skip_target,
+                             scalar_skip_value, scalar_find_crlf};
+
+#if defined(__x86_64__)
+
+// Each *_stops function returns a bit per byte of the block that may end
+// the run; bytes of 0x80 and above compare as negative. Tokens are mostly
+// letters, digits and '-', so only those pass the token kernel and the skip
+// loop steps over the other tchars one at a time.
+
+__m128i sse2_in_range(__m128i v, char low, char high) {
+  return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(low - 1))),
+                       _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(high + 1))));
+}
+
+std::uint32_t sse2_token_stops(const char* p) {
+  auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  auto common = _mm_or_si128(_mm_or_si128(sse2_in_range(v, '0', '9'), sse2_in_range(v, 'A', 'Z')),
+                             _mm_or_si128(sse2_in_range(v, 'a', 'z'),
+                                          _mm_cmpeq_epi8(v, _mm_set1_epi8('-'))));
+  return ~static_cast<std::uint32_t>(_mm_movemask_epi8(common)) & 0xffff;
+}
+
+// Control bytes, space and DEL.
+std::uint32_t sse2_target_stops(const char* p) {
+  auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  auto low = _mm_andnot_si128(_mm_cmplt_epi8(v, _mm_setzero_si128()),
+                              _mm_cmplt_epi8(v, _mm_set1_epi8(0x21)));
+  return _mm_movemask_epi8(_mm_or_si128(low, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f))));
+}
+
+// Control bytes but tab, and DEL.
+std::uint32_t sse2_value_stops(const char* p) {
+  auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  auto allowed = _mm_or_si128(_mm_cmplt_epi8(v, _mm_setzero_si128()),
+                              _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+  auto control = _mm_andnot_si128(allowed, _mm_cmplt_epi8(v, _mm_set1_epi8(0x20)));
+  return _mm_movemask_epi8(_mm_or_si128(control, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f))));
+}
+
+std::uint32_t sse2_carriage_returns(const char* p) {
+  auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+}
+
+template <std::uint32_t (*Stops)(const char*)>
+std::size_t sse2_skip(std::string_view data, std::size_t i, CharClass char_class) {
+  while (i + 16 <= data.size()) {
+    auto stops = Stops(data.data() + i);
+    if (stops == 0) {
+      i += 16;
+      continue;
+    }
+    i += __builtin_ctz(stops);
+    if (!is(data[i], char_class)) {
+      return i;
+    }
+    ++i;
+  }
+  return scalar_skip(data, i, char_class);
+}
+
+std::size_t sse2_skip_token(std::string_view data, std::size_t from) {
+  return sse2_skip<sse2_token_stops>(data, from, TOKEN);
+}
+
+std::size_t sse2_skip_target(std::string_view data, std::size_t from) {
+  return sse2_skip<sse2_target_stops>(data, from, TARGET);
+}
+
+std::size_t sse2_skip_value(std::string_view data, std::size_t from) {
+  return sse2_skip<sse2_value_stops>(data, from, VALUE);
+}
+
+std::size_t sse2_find_crlf(std::string_view data, std::size_t from) {
+  auto i = from;
+  for (; i + 16 <= data.size(); i += 16) {
+    for (auto crs = sse2_carriage_returns(data.data() + i); crs != 0; crs &= crs - 1) {
+      auto cr = i + __builtin_ctz(crs);
+      if (cr + 1 < data.size() && data[cr + 1] == '\n') {
+        return cr;
+      }
+    }
+  }
+  return scalar_find_crlf(data, i);
+}
+
+constexpr CharScanner SSE2{ScanLevel::sse2, sse2_skip_token, sse2_skip_target, sse2_skip_value,
+                           sse2_find_crlf};
+
+// The same kernels over 32 bytes. AVX2 has no signed "less than", so the
+// comparisons are turned around.
+
+__attribute__((target("avx2"))) __m256i avx2_in_range(__m256i v, char low, char high) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(low - 1))),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(high + 1)), v));
+}
+
+__attribute__((target("avx2"))) std::uint32_t avx2_token_stops(const char* p) {
+  auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  auto common =
+      _mm256_or_si256(_mm256_or_si256(avx2_in_range(v, '0', '9'), avx2_in_range(v, 'A', 'Z')),
+                      _mm256_or_si256(avx2_in_range(v, 'a', 'z'),
+                                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-'))));
+  return ~static_cast<std::uint32_t>(_mm256_movemask_epi8(common));
+}
+
+__attribute__((target("avx2"))) std::uint32_t avx2_target_stops(const char* p) {
+  auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  auto low = _mm256_andnot_si256(_mm256_cmpgt_epi8(_mm256_setzero_si256(), v),
+                                 _mm256_cmpgt_epi8(_mm256_set1_epi8(0x21), v));
+  return _mm256_movemask_epi8(_mm256_or_si256(low, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f))));
+}
+
+__attribute__((target("avx2"))) std::uint32_t avx2_value_stops(const char* p) {
+  auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  auto allowed = _mm256_or_si256(_mm256_cmpgt_epi8(_mm256_setzero_si256(), v),
+                                 _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+  auto control = _mm256_andnot_si256(allowed, _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v));
+  return _mm256_movemask_epi8(
+      _mm256_or_si256(control, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f))));
+}
+
+__attribute__((target("avx2"))) std::uint32_t avx2_carriage_returns(const char* p) {
+  auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  return _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+}
+
+// Most tokens are shorter than 32 bytes, so the rest goes to SSE2 before
+// the scalar loop. The upper halves of the registers are cleared first:
+// legacy SSE code running with them dirty is much slower.
+template <std::uint32_t (*Stops)(const char*), std::uint32_t (*Sse2Stops)(const char*)>
+__attribute__((target("avx2"))) std::size_t avx2_skip(std::string_view data, std::size_t i,
+                                                      CharClass char_class) {
+  while (i + 32 <= data.size()) {
+    auto stops = Stops(data.data() + i);
+    if (stops == 0) {
+      i += 32;
+      continue;
+    }
+    i += __builtin_ctz(stops);
+    if (!is(data[i], char_class)) {
+      return i;
+    }
+    ++i;
+  }
+  _mm256_zeroupper();
+  return sse2_skip<Sse2Stops>(data, i, char_class);
+}
+
+__attribute__((target("avx2"))) std::size_t avx2_skip_token(std::string_view data,
+                                                            std::size_t from) {
+  return avx2_skip<avx2_token_stops, sse2_token_stops>(data, from, TOKEN);
+}
+
+__attribute__((target("avx2"))) std::size_t avx2_skip_target(std::string_view data,
+                                                             std::size_t from) {
+  return avx2_skip<avx2_target_stops, sse2_target_stops>(data, from, TARGET);
+}
+
+__attribute__((target("avx2"))) std::size_t avx2_skip_value(std::string_view data,
+                                                            std::size_t from) {
+  return avx2_skip<avx2_value_stops, sse2_value_stops>(data, from, VALUE);
+}
+
+__attribute__((target("avx2"))) std::size_t avx2_find_crlf(std::string_view data,
+                                                           std::size_t from) {
+  auto i = from;
+  for (; i + 32 <= data.size(); i += 32) {
+    for (auto crs = avx2_carriage_returns(data.data() + i); crs != 0; crs &= crs - 1) {
+      auto cr = i + __builtin_ctz(crs);
+      if (cr + 1 < data.size() && data[cr + 1] == '\n') {
+        return cr;
+      }
+    }
+  }
+  _mm256_zeroupper();
+  return sse2_find_crlf(data, i);
+}
+
+constexpr CharScanner AVX2{ScanLevel::avx2, avx2_skip_token, avx2_skip_target, avx2_skip_value,
+                           avx2_find_crlf};
+
+#endif
+
+const CharScanner* detect() {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return &AVX2;
+  }
+  return &SSE2;
+#else
+  return &SCALAR;
+#endif
+}
+
+std::atomic<const CharScanner*>& active_scanner() {
+  static std::atomic<const CharScanner*> scanner{detect()};
+  return scanner;
+}
+
+} // namespace
+
+const CharScanner* CharScanner::get(ScanLevel level) {
+  switch (level) {
+  case ScanLevel::scalar:
+    return &SCALAR;
+#if defined(__x86_64__)
+  case ScanLevel::sse2:
+    return &SSE2;
+  case ScanLevel::avx2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? &AVX2 : nullptr;
+#endif
+  default:
+    return nullptr;
+  }
+}
+
+const CharScanner& CharScanner::active() {
+  return *active_scanner().load(std::memory_order_relaxed);
+}
+
+bool CharScanner::use(ScanLevel level) {
+  auto scanner = get(level);
+  if (scanner == nullptr) {
+    return false;
+  }
+  active_scanner().store(scanner, std::memory_order_relaxed);
+  return true;
+}
+
+} // namespace utils
+} // namespace web_server
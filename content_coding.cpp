@@ -0,0 +1,118 @@
+#include "include/content_coding.hpp"
+#include "include/utils.hpp"
+
+#include <algorithm>
+#include <zlib.h>
+
+namespace web_server {
+namespace message {
+
+namespace {
+
+// Bytes handed to and taken from zlib per call.
+constexpr std::size_t GZIP_STEP = 64 * 1024;
+
+// A qvalue is 0 only if all its digits are; anything malformed counts as 1.
+bool refused(std::string_view parameters) {
+  while (!parameters.empty()) {
+    auto semicolon = parameters.find(';');
+    auto parameter = utils::trim(parameters.substr(0, semicolon));
+    if (parameter.size() >= 2 && (parameter[0] == 'q' || parameter[0] == 'Q') &&
+        parameter[1] == '=') {
+      auto value = parameter.substr(2);
+      return !value.empty() && value[0] == '0' &&
+             value.find_first_not_of("0.", 1) == std::string_view::npos;
+    }
+    if (semicolon == std::string_view::npos) {
+      break;
+    }
+    parameters.remove_prefix(semicolon + 1);
+  }
+  return false;
+}
+
+} // namespace
+
+AcceptedCodings AcceptedCodings::parse(std::string_view accept_encoding) {
+  AcceptedCodings accepted{};
+  bool listed_br = false;
+  bool listed_gzip = false;
+  int wildcard = -1;
+  while (true) {
+    auto comma = accept_encoding.find(',');
+    auto element = accept_encoding.substr(0, comma);
+    auto semicolon = element.find(';');
+    auto coding = utils::trim(element.substr(0, semicolon));
+    auto accept = semicolon == std::string_view::npos || !refused(element.substr(semicolon + 1));
+    if (utils::equals_ignore_case(coding, "br")) {
+      listed_br = true;
+      accepted.br = accept;
+    } else if (utils::equals_ignore_case(coding, "gzip") ||
+               utils::equals_ignore_case(coding, "x-gzip")) {
+      listed_gzip = true;
+      accepted.gzip = accept;
+    } else if (coding == "*") {
+      wildcard = accept;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    accept_encoding.remove_prefix(comma + 1);
+  }
+  if (wildcard >= 0) {
+    accepted.br = listed_br ? accepted.br : wildcard;
+    accepted.gzip = listed_gzip ? accepted.gzip : wildcard;
+  }
+  return accepted;
+}
+
+std::string_view AcceptedCodings::name() const {
+  return CODING_VARIANTS[(br ? 1 : 0) + (gzip ? 2 : 0)];
+}
+
+std::string_view coding_extension(std::string_view coding) {
+  if (coding == "br") {
+    return ".br";
+  }
+  if (coding == "gzip") {
+    return ".gz";
+  }
+  return {};
+}
+
+bool gzip(std::string_view data, std::string& compressed, int level) {
+  z_stream stream{};
+  // 16 added to the window bits selects the gzip wrapper.
+  if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  compressed.clear();
+  compressed.reserve(deflateBound(&stream, data.size()));
+
+  int ret = Z_OK;
+  std::size_t consumed = 0;
+  int flush = Z_NO_FLUSH;
+  while (flush != Z_FINISH) {
+    auto step = std::min(data.size() - consumed, GZIP_STEP);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + consumed));
+    stream.avail_in = static_cast<uInt>(step);
+    consumed += step;
+    flush = consumed == data.size() ? Z_FINISH : Z_NO_FLUSH;
+    do {
+      auto size = compressed.size();
+      compressed.resize(size + GZIP_STEP);
+      stream.next_out = reinterpret_cast<Bytef*>(compressed.data() + size);
+      stream.avail_out = static_cast<uInt>(GZIP_STEP);
+      ret = deflate(&stream, flush);
+      compressed.resize(size + GZIP_STEP - stream.avail_out);
+    } while (stream.avail_out == 0 && ret == Z_OK);
+    if (ret == Z_STREAM_ERROR) {
+      break;
+    }
+  }
+  deflateEnd(&stream);
+  return ret == Z_STREAM_END;
+}
+
+} // namespace message
+} // namespace web_server
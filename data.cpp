@@ -19,7 +19,7 @@ Data::Data(const std::uint8_t* data, std::size_t size, std::uint32_t connection_
 
 Data::Data(const Data& data)
     : _allocator(), _data(_allocator.allocate(data._size)), _size(data._size),
-      _connection_id(data._connection_id) {
+      _capacity(data._size), _connection_id(data._connection_id), _sequence(data._sequence) {
   std::memcpy(_data, data._data, _size);
 }
 
@@ -28,7 +28,9 @@ Data& Data::operator=(const Data& data) {
     _allocator.deallocate(_data, _size);
     _data = _allocator.allocate(data._size);
     _size = data._size;
+    _capacity = data._size;
     _connection_id = data._connection_id;
+    _sequence = data._sequence;
     std::memcpy(_data, data._data, _size);
   }
   return *this;
@@ -43,11 +45,13 @@ Data::Data(Data&& data) {
   _size = data._size;
   _capacity = data._capacity;
   _connection_id = data._connection_id;
+  _sequence = data._sequence;
 
   data._data = nullptr;
   data._size = 0;
   data._capacity = 0;
   data._connection_id = 0;
+  data._sequence = 0;
 }
 
 Data& Data::operator=(Data&& data) {
@@ -64,11 +68,13 @@ Data& Data::operator=(Data&& data) {
   _size = data._size;
   _capacity = data._capacity;
   _connection_id = data._connection_id;
+  _sequence = data._sequence;
 
   data._data = nullptr;
   data._size = 0;
   data._capacity = 0;
   data._connection_id = 0;
+  data._sequence = 0;
   return *this;
 }
 
@@ -97,6 +103,7 @@ void Data::clear() {
   _data = nullptr;
   _size = 0;
   _connection_id = 0;
+  _sequence = 0;
   _capacity = 0;
 }
 
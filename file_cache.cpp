@@ -0,0 +1,331 @@
+#include "include/file_cache.hpp"
+#include "include/logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace web_server {
+namespace message {
+
+namespace {
+
+// Everything that changes a file's contents or metadata, or what a path
+// refers to.
+constexpr std::uint32_t WATCH_MASK = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE |
+                                     IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF |
+                                     IN_MOVE_SELF | IN_ONLYDIR;
+
+bool is_below(const std::filesystem::path& path, const std::filesystem::path& root) {
+  auto relative = path.lexically_relative(root);
+  return !relative.empty() && *relative.begin() != ".." && *relative.begin() != ".";
+}
+
+// The file a precompressed sibling belongs to, or path itself.
+std::filesystem::path origin(const std::filesystem::path& path) {
+  for (auto coding : CODING_VARIANTS) {
+    auto extension = coding_extension(coding);
+    if (!extension.empty() && path.extension() == extension) {
+      return path.parent_path() / path.stem();
+    }
+  }
+  return path;
+}
+
+} // namespace
+
+FileCache::FileCache(std::filesystem::path root, FileCacheOptions options)
+    : _root(std::move(root)), _options(options) {
+  if (_options.capacity == 0) {
+    return;
+  }
+  _inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  _stop_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_inotify_fd < 0 || _stop_fd < 0) {
+    utils::Logger::logger().warning("FileCache::inotify is not available, caching is disabled: " +
+                                    std::string(std::strerror(errno)));
+    if (_inotify_fd >= 0) {
+      ::close(_inotify_fd);
+      _inotify_fd = -1;
+    }
+    if (_stop_fd >= 0) {
+      ::close(_stop_fd);
+      _stop_fd = -1;
+    }
+    return;
+  }
+  _watching = true;
+  _watcher = std::thread(&FileCache::run_watcher, this);
+}
+
+FileCache::~FileCache() {
+  if (_watcher.joinable()) {
+    std::uint64_t value = 1;
+    [[maybe_unused]] auto ret = ::write(_stop_fd, &value, sizeof(value));
+    _watcher.join();
+  }
+  if (_inotify_fd >= 0) {
+    ::close(_inotify_fd);
+  }
+  if (_stop_fd >= 0) {
+    ::close(_stop_fd);
+  }
+}
+
+FileCache::Entry FileCache::find(const std::filesystem::path& key, std::string_view variant) {
+  if (!enabled()) {
+    return nullptr;
+  }
+  auto name = entry_name(key, variant);
+  auto& target = shard(name);
+  std::scoped_lock<std::mutex> lock{target.mutex};
+  auto it = target.index.find(name);
+  if (it == target.index.end()) {
+    ++_stats.misses;
+    return nullptr;
+  }
+  target.lru.splice(target.lru.begin(), target.lru, it->second);
+  ++_stats.hits;
+  return it->second->second;
+}
+
+FileCache::Entry FileCache::load(const std::filesystem::path& key,
+                                 const std::filesystem::path& path, const Prepare& prepare,
+                                 std::string_view variant) {
+  auto file_path = variant.empty() ? path : origin(path);
+  auto directory = file_path.parent_path();
+  auto index = key != file_path && file_path.filename() == "index.html";
+  if (!enabled() ||
+      std::find(CODING_VARIANTS.begin(), CODING_VARIANTS.end(), variant) ==
+          CODING_VARIANTS.end() ||
+      (key != file_path && !(index && (key == directory || key == directory / ""))) ||
+      !is_below(path, _root)) {
+    return nullptr;
+  }
+  // Changes reported from here on discard the load.
+  auto generation = _generation.load();
+  std::error_code ec;
+  if (std::filesystem::canonical(path, ec) != path || ec || !watch(path)) {
+    return nullptr;
+  }
+
+  auto file = File::open(path);
+  if (!file || !file->is_regular() || file->size() > _options.max_file_size ||
+      std::time(nullptr) - file->modified() < 1) {
+    return nullptr;
+  }
+  auto cached = std::make_shared<CachedFile>();
+  cached->path = path;
+  cached->metadata = file->metadata();
+  cached->body.resize(file->size());
+  FileRegion region{file, 0, file->size()};
+  for (std::uint64_t read = 0; read < file->size();) {
+    read += region.read(read, reinterpret_cast<std::uint8_t*>(cached->body.data()) + read,
+                        file->size() - read, ec);
+    if (ec) {
+      return nullptr;
+    }
+  }
+  prepare(*cached);
+
+  auto name = entry_name(key, variant);
+  auto size = charge(name, *cached);
+  auto budget = _options.capacity / SHARD_COUNT;
+  if (size > budget) {
+    return cached;
+  }
+  auto& target = shard(name);
+  std::scoped_lock<std::mutex> lock{target.mutex};
+  if (_generation.load() != generation) {
+    return cached;
+  }
+  if (auto it = target.index.find(name); it != target.index.end()) {
+    erase(target, it->second);
+  }
+  target.lru.emplace_front(name, cached);
+  target.index.emplace(name, target.lru.begin());
+  target.size += size;
+  while (target.size > budget) {
+    erase(target, std::prev(target.lru.end()));
+    ++_stats.evictions;
+  }
+  return cached;
+}
+
+void FileCache::invalidate(const std::filesystem::path& path, bool directory) {
+  ++_generation;
+  if (!directory) {
+    auto file_path = origin(path);
+    drop(path);
+    if (file_path != path) {
+      drop(file_path);
+    }
+    if (file_path.filename() == "index.html") {
+      // A directory is cached under its own path, with or without a slash.
+      drop(file_path.parent_path());
+      drop(file_path.parent_path() / "");
+    }
+    return;
+  }
+
+  const auto& name = path.native();
+  for (auto& target : _shards) {
+    std::scoped_lock<std::mutex> lock{target.mutex};
+    for (auto it = target.lru.begin(); it != target.lru.end();) {
+      std::string_view key{it->first};
+      key = key.substr(0, key.find('\0'));
+      auto next = std::next(it);
+      if (key.starts_with(name) && (key.size() == name.size() || key[name.size()] == '/')) {
+        erase(target, it);
+        ++_stats.invalidations;
+      }
+      it = next;
+    }
+  }
+}
+
+void FileCache::clear() {
+  ++_generation;
+  for (auto& target : _shards) {
+    std::scoped_lock<std::mutex> lock{target.mutex};
+    _stats.invalidations += target.lru.size();
+    target.index.clear();
+    target.lru.clear();
+    target.size = 0;
+  }
+}
+
+std::size_t FileCache::size() const {
+  std::size_t size = 0;
+  for (const auto& target : _shards) {
+    std::scoped_lock<std::mutex> lock{target.mutex};
+    size += target.size;
+  }
+  return size;
+}
+
+std::size_t FileCache::count() const {
+  std::size_t count = 0;
+  for (const auto& target : _shards) {
+    std::scoped_lock<std::mutex> lock{target.mutex};
+    count += target.lru.size();
+  }
+  return count;
+}
+
+std::string FileCache::entry_name(const std::filesystem::path& key, std::string_view variant) {
+  std::string name{key.native()};
+  name += '\0';
+  name += variant;
+  return name;
+}
+
+std::size_t FileCache::charge(const std::string& name, const CachedFile& file) {
+  return ENTRY_OVERHEAD + name.size() + file.path.native().size() + file.header.size() +
+         file.fields.size() + file.entity_tag.size() + file.body.size();
+}
+
+FileCache::Shard& FileCache::shard(const std::string& name) {
+  return _shards[std::hash<std::string>{}(name) % SHARD_COUNT];
+}
+
+void FileCache::drop(const std::filesystem::path& key) {
+  for (auto variant : CODING_VARIANTS) {
+    auto name = entry_name(key, variant);
+    auto& target = shard(name);
+    std::scoped_lock<std::mutex> lock{target.mutex};
+    if (auto it = target.index.find(name); it != target.index.end()) {
+      erase(target, it->second);
+      ++_stats.invalidations;
+    }
+  }
+}
+
+void FileCache::erase(Shard& shard, Shard::Lru::iterator it) {
+  shard.size -= charge(it->first, *it->second);
+  shard.index.erase(it->first);
+  shard.lru.erase(it);
+}
+
+bool FileCache::watch(const std::filesystem::path& path) {
+  for (auto directory = path.parent_path();; directory = directory.parent_path()) {
+    int wd = ::inotify_add_watch(_inotify_fd, directory.c_str(), WATCH_MASK);
+    if (wd < 0) {
+#ifdef DEBUG
+      utils::Logger::logger().debug("FileCache::Failed to watch " + directory.string() + ": " +
+                                    std::strerror(errno));
+#endif
+      return false;
+    }
+    {
+      std::scoped_lock<std::mutex> lock{_watch_mutex};
+      _watches[wd] = directory;
+    }
+    if (directory == _root || !is_below(directory, _root)) {
+      return true;
+    }
+  }
+}
+
+void FileCache::run_watcher() {
+  alignas(struct inotify_event) char events[16 * 1024];
+  pollfd fds[2] = {{_inotify_fd, POLLIN, 0}, {_stop_fd, POLLIN, 0}};
+  while (true) {
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Nothing can be invalidated anymore.
+      utils::Logger::logger().error("FileCache::Watcher failed, caching is disabled: " +
+                                    std::string(std::strerror(errno)));
+      _watching = false;
+      clear();
+      return;
+    }
+    if (fds[1].revents != 0) {
+      return;
+    }
+    ssize_t size;
+    while ((size = ::read(_inotify_fd, events, sizeof(events))) > 0) {
+      handle_events(events, size);
+    }
+  }
+}
+
+void FileCache::handle_events(const char* events, std::size_t size) {
+  for (std::size_t offset = 0; offset < size;) {
+    const auto* event = reinterpret_cast<const struct inotify_event*>(events + offset);
+    offset += sizeof(struct inotify_event) + event->len;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+      // Events were lost; any entry may be stale.
+      clear();
+      continue;
+    }
+    std::filesystem::path directory{};
+    {
+      std::scoped_lock<std::mutex> lock{_watch_mutex};
+      auto it = _watches.find(event->wd);
+      if (it == _watches.end()) {
+        continue;
+      }
+      directory = it->second;
+      if (event->mask & IN_IGNORED) {
+        _watches.erase(it);
+      }
+    }
+    if (event->len > 0) {
+      invalidate(directory / event->name, event->mask & IN_ISDIR);
+    } else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+      invalidate(directory, true);
+    }
+  }
+}
+
+} // namespace message
+} // namespace web_server
@@ -0,0 +1,90 @@
+#include "include/file_region.hpp"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace web_server {
+namespace message {
+
+namespace {
+
+FileMetadata to_metadata(const struct stat& st) {
+  FileMetadata metadata{};
+  metadata.is_regular = S_ISREG(st.st_mode);
+  metadata.is_directory = S_ISDIR(st.st_mode);
+  metadata.size = st.st_size;
+  metadata.modified = st.st_mtim.tv_sec;
+  metadata.modified_nsec = static_cast<std::uint32_t>(st.st_mtim.tv_nsec);
+  metadata.inode = st.st_ino;
+  return metadata;
+}
+
+} // namespace
+
+std::optional<FileMetadata> FileMetadata::stat(const std::filesystem::path& path) {
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0) {
+    return std::nullopt;
+  }
+  return to_metadata(st);
+}
+
+File::File(int fd): _fd(fd) {
+  struct stat st;
+  if (::fstat(_fd, &st) == 0) {
+    _metadata = to_metadata(st);
+  }
+}
+
+File::~File() {
+  if (_fd >= 0) {
+    ::close(_fd);
+  }
+}
+
+std::shared_ptr<File> File::open(const std::filesystem::path& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  return std::make_shared<File>(fd);
+}
+
+std::size_t FileRegion::send_to(int socket_fd, std::uint64_t sent, std::error_code& ec) const {
+  off_t offset = _offset + sent;
+  ssize_t ret = ::sendfile(socket_fd, _file->fd(), &offset, _length - sent);
+  if (ret < 0) {
+    ec.assign(errno, std::system_category());
+    return 0;
+  }
+  if (ret == 0 && sent < _length) {
+    // The file shrank after the response header was generated.
+    ec = std::make_error_code(std::errc::io_error);
+    return 0;
+  }
+  ec.clear();
+  return ret;
+}
+
+std::size_t FileRegion::read(std::uint64_t sent, std::uint8_t* buffer, std::size_t size,
+                             std::error_code& ec) const {
+  size = std::min<std::uint64_t>(size, _length - sent);
+  ssize_t ret = ::pread(_file->fd(), buffer, size, _offset + sent);
+  if (ret < 0) {
+    ec.assign(errno, std::system_category());
+    return 0;
+  }
+  if (ret == 0 && size > 0) {
+    // The file shrank after the response header was generated.
+    ec = std::make_error_code(std::errc::io_error);
+    return 0;
+  }
+  ec.clear();
+  return ret;
+}
+
+} // namespace message
+} // namespace web_server
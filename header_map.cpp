@@ -0,0 +1,245 @@
+#include "include/header_map.hpp"
+#include "include/utils.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace web_server {
+namespace message {
+
+namespace {
+
+constexpr std::array<std::string_view, HEADER_ID_COUNT> NAMES{
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Accept-Ranges",
+    "Age",
+    "Allow",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Disposition",
+    "Content-Encoding",
+    "Content-Language",
+    "Content-Length",
+    "Content-Location",
+    "Content-Range",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "ETag",
+    "Expect",
+    "Expires",
+    "Host",
+    "If-Match",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "If-Unmodified-Since",
+    "Keep-Alive",
+    "Last-Modified",
+    "Location",
+    "Origin",
+    "Pragma",
+    "Range",
+    "Referer",
+    "Retry-After",
+    "Server",
+    "Set-Cookie",
+    "TE",
+    "Trailer",
+    "Transfer-Encoding",
+    "Upgrade",
+    "User-Agent",
+    "Vary",
+    "Via",
+    "WWW-Authenticate",
+};
+
+// Cheap enough to run on every received field name: its length and three
+// of its bytes, lowercased. The factors were picked so that the well-known
+// names do not collide.
+constexpr std::uint32_t hash(std::string_view name) {
+  if (name.empty()) {
+    return 0;
+  }
+  auto byte = [name](std::size_t i) {
+    return static_cast<std::uint32_t>(static_cast<unsigned char>(utils::to_lower(name[i])));
+  };
+  return static_cast<std::uint32_t>(name.size()) * 8 + byte(0) * 3 + byte(name.size() / 2) +
+         byte(name.size() - 1) * 7;
+}
+
+// An open addressing table from hash to id + 1, 0 marking empty slots.
+constexpr std::size_t SLOT_COUNT = 128;
+
+constexpr std::array<std::uint8_t, SLOT_COUNT> make_slots() {
+  std::array<std::uint8_t, SLOT_COUNT> slots{};
+  for (std::size_t id = 0; id < HEADER_ID_COUNT; ++id) {
+    auto slot = hash(NAMES[id]) % SLOT_COUNT;
+    while (slots[slot] != 0) {
+      slot = (slot + 1) % SLOT_COUNT;
+    }
+    slots[slot] = static_cast<std::uint8_t>(id + 1);
+  }
+  return slots;
+}
+
+constexpr auto SLOTS = make_slots();
+
+constexpr std::size_t MAX_NAME_SIZE =
+    std::max_element(NAMES.begin(), NAMES.end(), [](auto a, auto b) {
+      return a.size() < b.size();
+    })->size();
+
+} // namespace
+
+HeaderId header_id(std::string_view name) {
+  if (name.size() > MAX_NAME_SIZE) {
+    return HeaderId::other;
+  }
+  for (auto slot = hash(name) % SLOT_COUNT; SLOTS[slot] != 0; slot = (slot + 1) % SLOT_COUNT) {
+    auto id = SLOTS[slot] - 1;
+    if (utils::equals_ignore_case(NAMES[id], name)) {
+      return static_cast<HeaderId>(id);
+    }
+  }
+  return HeaderId::other;
+}
+
+std::string_view header_name(HeaderId id) {
+  return id == HeaderId::other ? std::string_view{} : NAMES[static_cast<std::size_t>(id)];
+}
+
+template <typename Value>
+void BasicHeaderMap<Value>::add(std::string_view name, std::string_view value) {
+  auto id = header_id(name);
+  if (id != HeaderId::set_cookie) {
+    if (auto field = find_field(id, name)) {
+      if constexpr (std::is_same_v<Value, std::string>) {
+        field->value += ", ";
+        field->value += value;
+      } else {
+        auto combined = std::make_shared<std::string>(field->value);
+        *combined += ", ";
+        *combined += value;
+        field->value = *combined;
+        _combined.push_back(std::move(combined));
+      }
+      return;
+    }
+  }
+  append(id, name, value);
+}
+
+template <typename Value>
+void BasicHeaderMap<Value>::set(std::string_view name, std::string_view value) {
+  auto id = header_id(name);
+  if (auto field = find_field(id, name)) {
+    field->value = value;
+    return;
+  }
+  append(id, name, value);
+}
+
+template <typename Value>
+void BasicHeaderMap<Value>::set(HeaderId id, std::string_view value) {
+  if (auto field = find_field(id, header_name(id))) {
+    field->value = value;
+    return;
+  }
+  append(id, header_name(id), value);
+}
+
+template <typename Value>
+bool BasicHeaderMap<Value>::erase(std::string_view name) {
+  auto id = header_id(name);
+  auto removed = std::remove_if(_fields.begin(), _fields.end(), [id, name](const Field& field) {
+    return field.id == id &&
+           (id != HeaderId::other || utils::equals_ignore_case(field.other_name, name));
+  });
+  if (removed == _fields.end()) {
+    return false;
+  }
+  _fields.erase(removed, _fields.end());
+  _index.fill(0);
+  for (std::size_t i = _fields.size(); i > 0; --i) {
+    if (_fields[i - 1].id != HeaderId::other) {
+      _index[static_cast<std::size_t>(_fields[i - 1].id)] = static_cast<std::uint16_t>(i);
+    }
+  }
+  return true;
+}
+
+template <typename Value>
+void BasicHeaderMap<Value>::clear() {
+  _fields.clear();
+  _index.fill(0);
+  _combined.clear();
+}
+
+template <typename Value>
+const Value* BasicHeaderMap<Value>::find(HeaderId id) const {
+  auto field = find_field(id, header_name(id));
+  return field == nullptr ? nullptr : &field->value;
+}
+
+template <typename Value>
+const Value* BasicHeaderMap<Value>::find(std::string_view name) const {
+  auto field = find_field(header_id(name), name);
+  return field == nullptr ? nullptr : &field->value;
+}
+
+template <typename Value>
+const Value& BasicHeaderMap<Value>::at(HeaderId id) const {
+  auto value = find(id);
+  if (value == nullptr) {
+    throw std::out_of_range("HeaderMap::No field " + std::string(header_name(id)));
+  }
+  return *value;
+}
+
+template <typename Value>
+const Value& BasicHeaderMap<Value>::at(std::string_view name) const {
+  auto value = find(name);
+  if (value == nullptr) {
+    throw std::out_of_range("HeaderMap::No field " + std::string(name));
+  }
+  return *value;
+}
+
+template <typename Value>
+typename BasicHeaderMap<Value>::Field* BasicHeaderMap<Value>::find_field(HeaderId id,
+                                                                        std::string_view name) {
+  return const_cast<Field*>(std::as_const(*this).find_field(id, name));
+}
+
+template <typename Value>
+const typename BasicHeaderMap<Value>::Field*
+BasicHeaderMap<Value>::find_field(HeaderId id, std::string_view name) const {
+  if (id != HeaderId::other) {
+    auto position = _index[static_cast<std::size_t>(id)];
+    return position == 0 ? nullptr : &_fields[position - 1];
+  }
+  auto it = std::find_if(_fields.begin(), _fields.end(), [name](const Field& field) {
+    return field.id == HeaderId::other && utils::equals_ignore_case(field.other_name, name);
+  });
+  return it == _fields.end() ? nullptr : &*it;
+}
+
+template <typename Value>
+void BasicHeaderMap<Value>::append(HeaderId id, std::string_view name, std::string_view value) {
+  _fields.push_back(Field{id, id == HeaderId::other ? Value(name) : Value{}, Value(value)});
+  if (id != HeaderId::other && _index[static_cast<std::size_t>(id)] == 0) {
+    _index[static_cast<std::size_t>(id)] = static_cast<std::uint16_t>(_fields.size());
+  }
+}
+
+template class BasicHeaderMap<std::string>;
+template class BasicHeaderMap<std::string_view>;
+
+} // namespace message
+} // namespace web_server
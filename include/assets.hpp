@@ -33,6 +33,71 @@ inline const std::string BAD_GATEWAY_RESPONSE{"HTTP/1.1 502 Bad Gateway\r\n"
                                               "<body><h1>502 Bad Gateway</h1></body>"
                                               "</html>"};
 
+// Sent as is when the server sheds load, so it costs no allocation.
+inline const std::string SERVICE_UNAVAILABLE_RESPONSE{
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Length: 109\r\n"
+    "Content-Type: text/html\r\n"
+    "Retry-After: 1\r\n"
+    "\r\n"
+    "<html>"
+    "<head><title>503 Service Unavailable</title></head>"
+    "<body><h1>503 Service Unavailable</h1></body>"
+    "</html>"};
+
+// Sent as is when a request header exceeds connection::Limits; the
+// connection is closed afterwards.
+inline const std::string URI_TOO_LONG_RESPONSE{"HTTP/1.1 414 URI Too Long\r\n"
+                                               "Connection: close\r\n"
+                                               "Content-Length: 95\r\n"
+                                               "Content-Type: text/html\r\n"
+                                               "\r\n"
+                                               "<html>"
+                                               "<head><title>414 URI Too Long</title></head>"
+                                               "<body><h1>414 URI Too Long</h1></body>"
+                                               "</html>"};
+
+inline const std::string REQUEST_HEADER_FIELDS_TOO_LARGE_RESPONSE{
+    "HTTP/1.1 431 Request Header Fields Too Large\r\n"
+    "Connection: close\r\n"
+    "Content-Length: 133\r\n"
+    "Content-Type: text/html\r\n"
+    "\r\n"
+    "<html>"
+    "<head><title>431 Request Header Fields Too Large</title></head>"
+    "<body><h1>431 Request Header Fields Too Large</h1></body>"
+    "</html>"};
+
+// Sent as is for a request with an unknown method or an HTTP version other
+// than 1.x; the connection is closed afterwards.
+inline const std::string NOT_IMPLEMENTED_RESPONSE{"HTTP/1.1 501 Not Implemented\r\n"
+                                                  "Connection: close\r\n"
+                                                  "Content-Length: 101\r\n"
+                                                  "Content-Type: text/html\r\n"
+                                                  "\r\n"
+                                                  "<html>"
+                                                  "<head><title>501 Not Implemented</title></head>"
+                                                  "<body><h1>501 Not Implemented</h1></body>"
+                                                  "</html>"};
+
+inline const std::string HTTP_VERSION_NOT_SUPPORTED_RESPONSE{
+    "HTTP/1.1 505 HTTP Version Not Supported\r\n"
+    "Connection: close\r\n"
+    "Content-Length: 123\r\n"
+    "Content-Type: text/html\r\n"
+    "\r\n"
+    "<html>"
+    "<head><title>505 HTTP Version Not Supported</title></head>"
+    "<body><h1>505 HTTP Version Not Supported</h1></body>"
+    "</html>"};
+
+// Body of a 416 response; the header carries the size in Content-Range.
+inline const std::string RANGE_NOT_SATISFIABLE_BODY{
+    "<html>"
+    "<head><title>416 Range Not Satisfiable</title></head>"
+    "<body><h1>416 Range Not Satisfiable</h1></body>"
+    "</html>"};
+
 } // namespace assets
 } // namespace web_server
 
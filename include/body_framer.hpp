@@ -0,0 +1,91 @@
+/*
+ * BodyFramer class
+ * Finds where a request body ends. start() reads the framing from the
+ * fields RequestParser found in the request header: a Content-Length,
+ * chunked Transfer-Encoding, or no body.
+ * decode() is then fed the bytes following the header as they arrive and
+ * returns the body bytes among them, so a body can be consumed piece by
+ * piece without ever being buffered whole.
+ *
+ * Chunked bodies are decoded with a byte-wise state machine, so a chunk
+ * size line or trailer may be split across any number of reads. Chunk
+ * extensions and trailer fields are skipped.
+ */
+#ifndef BODY_FRAMER_H_
+#define BODY_FRAMER_H_
+
+#include "request_parser.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace web_server {
+namespace message {
+
+class BodyFramer {
+public:
+  enum class Framing { none, length, chunked };
+  enum class Status { incomplete, complete, error };
+
+  BodyFramer() = default;
+
+  // Reads the framing from the fields of a complete request. Returns false
+  // if it is malformed or ambiguous: an invalid or repeated Content-Length,
+  // a Transfer-Encoding not ending in chunked, or both.
+  bool start(const RequestParser& parser);
+
+  Framing framing() const { return _framing; }
+  // The body size for Framing::length.
+  std::uint64_t content_length() const { return _remaining_length; }
+  bool done() const { return _state == State::done; }
+
+  // Decodes the front of data. Appends the body bytes found, as views into
+  // data, to body and sets consumed to the number of bytes that belonged to
+  // the body framing; bytes after the end of the body are left alone.
+  Status decode(std::string_view data, std::size_t& consumed, std::vector<std::string_view>& body);
+
+private:
+  // Longest chunk size line, with extensions, and longest trailer section.
+  static constexpr std::size_t MAX_LINE_SIZE = 4 * 1024;
+  static constexpr std::size_t MAX_TRAILER_SIZE = 8 * 1024;
+
+  enum class State {
+    length,
+    chunk_size,
+    chunk_extension,
+    chunk_size_lf,
+    chunk_data,
+    chunk_data_cr,
+    chunk_data_lf,
+    trailer,
+    trailer_lf,
+    done
+  };
+
+  void begin();
+  // Returns false if the field makes the framing invalid.
+  bool add_field(std::string_view key, std::string_view value);
+  bool finish();
+  Status decode_chunked(std::string_view data, std::size_t& consumed,
+                        std::vector<std::string_view>& body);
+
+  Framing _framing{Framing::none};
+  State _state{State::done};
+  std::uint64_t _remaining_length{0};
+  std::uint64_t _chunk_size{0};
+  std::size_t _line_size{0};
+  std::size_t _trailer_size{0};
+  // Bytes of the trailer line being read; 0 at an empty line ends the body.
+  std::size_t _trailer_line_size{0};
+  bool _has_chunk_size{false};
+  // Seen by start() so far.
+  bool _has_length{false};
+  bool _has_transfer_encoding{false};
+  bool _chunked{false};
+};
+
+} // namespace message
+} // namespace web_server
+
+#endif // BODY_FRAMER_H_
@@ -0,0 +1,59 @@
+#ifndef BUFFER_H_
+#define BUFFER_H_
+
+#include "data.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace web_server {
+namespace message {
+
+// A read-only slice of memory. The memory is either kept alive by a shared
+// owner, so slices of one allocation can be sent without copying, or has
+// static storage duration (canned responses).
+class Buffer {
+public:
+  Buffer() = delete;
+  Buffer(std::shared_ptr<const void> owner, const std::uint8_t* data, std::size_t size)
+      : _owner(std::move(owner)), _data(data), _size(size) {}
+
+  // Refers to memory that outlives every response, e.g. the assets.
+  static Buffer view(std::string_view data) {
+    return Buffer(nullptr, reinterpret_cast<const std::uint8_t*>(data.data()), data.size());
+  }
+  static Buffer own(std::string data) {
+    auto owner = std::make_shared<const std::string>(std::move(data));
+    return Buffer(owner, reinterpret_cast<const std::uint8_t*>(owner->data()), owner->size());
+  }
+  static Buffer own(Data data) {
+    auto owner = std::make_shared<const Data>(std::move(data));
+    return Buffer(owner, owner->data(), owner->size());
+  }
+
+  const std::uint8_t* data() const { return _data; }
+  std::size_t size() const { return _size; }
+  // Whether the memory is kept alive by this buffer rather than by whoever
+  // made the view.
+  bool shared() const { return _owner != nullptr; }
+  std::string_view to_string_view() const {
+    return std::string_view(reinterpret_cast<const char*>(_data), _size);
+  }
+
+  Buffer slice(std::size_t start, std::size_t count = std::string::npos) const {
+    start = std::min(start, _size);
+    count = std::min(count, _size - start);
+    return Buffer(_owner, _data + start, count);
+  }
+
+private:
+  std::shared_ptr<const void> _owner;
+  const std::uint8_t* _data;
+  std::size_t _size;
+};
+
+} // namespace message
+} // namespace web_server
+
+#endif // BUFFER_H_
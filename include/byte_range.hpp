@@ -0,0 +1,46 @@
+/*
+ * Byte ranges
+ * Parsing of the Range request header (RFC 9110, section 14) against a
+ * representation of a known size. Ranges are resolved to absolute,
+ * inclusive offsets clamped to the representation.
+ */
+#ifndef BYTE_RANGE_H_
+#define BYTE_RANGE_H_
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace web_server {
+namespace message {
+
+struct ByteRange {
+  std::uint64_t first{0};
+  std::uint64_t last{0};
+
+  std::uint64_t length() const { return last - first + 1; }
+  bool operator==(const ByteRange&) const = default;
+};
+
+enum class RangeStatus {
+  // No usable Range header: malformed, not in bytes, or too many ranges.
+  // The whole representation is sent.
+  ignored,
+  satisfiable,
+  // No range overlaps the representation; answered 416.
+  unsatisfiable
+};
+
+// Ranges beyond this count make the header ignored.
+inline constexpr std::size_t MAX_BYTE_RANGES = 64;
+
+// Parses a Range header value for a representation of size bytes. The
+// satisfiable ranges are stored in ranges, in request order, unless some
+// overlap; then they are sorted and merged.
+RangeStatus parse_byte_ranges(std::string_view value, std::uint64_t size,
+                              std::vector<ByteRange>& ranges);
+
+} // namespace message
+} // namespace web_server
+
+#endif // BYTE_RANGE_H_
@@ -0,0 +1,84 @@
+/*
+ * Character scanning kernels
+ * Find where a run of header bytes of one class ends, and where the next
+ * CRLF is, 16 or 32 bytes at a time. The widest implementation the CPU
+ * supports is picked once at startup (AVX2, then SSE2, then a portable
+ * scalar loop); every implementation returns exactly what the scalar one
+ * does.
+ */
+#ifndef CHAR_SCAN_H_
+#define CHAR_SCAN_H_
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace web_server {
+namespace utils {
+
+enum CharClass : std::uint8_t {
+  // A byte of a method or field name (tchar, RFC 9110 section 5.6.2).
+  TOKEN = 1,
+  // A byte of a request target or version: any visible byte.
+  TARGET = 2,
+  // A byte of a field value: visible bytes, obs-text, space and tab.
+  VALUE = 4
+};
+
+constexpr std::array<std::uint8_t, 256> make_char_classes() {
+  std::array<std::uint8_t, 256> classes{};
+  for (int c = 0; c < 256; ++c) {
+    bool visible = (c > 0x20 && c < 0x7f) || c >= 0x80;
+    bool token = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                 std::string_view("!#$%&'*+-.^_`|~").find(static_cast<char>(c)) !=
+                     std::string_view::npos;
+    classes[c] = (token ? TOKEN : 0) | (visible ? TARGET : 0) |
+                 (visible || c == ' ' || c == '\t' ? VALUE : 0);
+  }
+  return classes;
+}
+
+inline constexpr auto CHAR_CLASSES = make_char_classes();
+
+inline bool is(char c, CharClass char_class) {
+  return CHAR_CLASSES[static_cast<unsigned char>(c)] & char_class;
+}
+
+enum class ScanLevel { scalar, sse2, avx2 };
+
+// One implementation of the kernels. The skip functions return the index of
+// the first byte at or after from that is not of their class, or
+// data.size(); find_crlf returns the index of the next "\r\n" or npos.
+struct CharScanner {
+  ScanLevel level;
+  std::size_t (*skip_token)(std::string_view data, std::size_t from);
+  std::size_t (*skip_target)(std::string_view data, std::size_t from);
+  std::size_t (*skip_value)(std::string_view data, std::size_t from);
+  std::size_t (*find_crlf)(std::string_view data, std::size_t from);
+
+  // The implementation for level, or nullptr if the CPU lacks it.
+  static const CharScanner* get(ScanLevel level);
+  // The implementation in use.
+  static const CharScanner& active();
+  // Switches to level, e.g. to compare implementations. Returns false, and
+  // keeps the current one, if the CPU lacks it.
+  static bool use(ScanLevel level);
+};
+
+inline std::size_t skip_token(std::string_view data, std::size_t from) {
+  return CharScanner::active().skip_token(data, from);
+}
+inline std::size_t skip_target(std::string_view data, std::size_t from) {
+  return CharScanner::active().skip_target(data, from);
+}
+inline std::size_t skip_value(std::string_view data, std::size_t from) {
+  return CharScanner::active().skip_value(data, from);
+}
+inline std::size_t find_crlf(std::string_view data, std::size_t from) {
+  return CharScanner::active().find_crlf(data, from);
+}
+
+} // namespace utils
+} // namespace web_server
+
+#endif // CHAR_SCAN_H_
@@ -1,17 +1,38 @@
 #ifndef CONNECTION_H_
 #define CONNECTION_H_
 
+#include "assets.hpp"
+#include "body_framer.hpp"
 #include "data.hpp"
-#include "data_buffer.hpp"
 #include "logger.hpp"
-#include "queue.hpp"
+#include "payload.hpp"
+#include "request.hpp"
+#include "request_parser.hpp"
+#include "thread_pool.hpp"
+#include "timer_service.hpp"
 #include "utils.hpp"
 
+#include <algorithm>
+#include <array>
 #include <boost/asio.hpp>
 #include <chrono>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#ifdef USE_IO_URING
+#include <unistd.h>
+#ifndef BOOST_ASIO_HAS_FILE
+#error "USE_IO_URING requires Boost.Asio with io_uring file support (Boost 1.78 or later)"
+#endif
+#endif
 
 namespace web_server {
 namespace connection {
@@ -19,13 +40,57 @@ namespace connection {
 template <typename T>
 concept Socket = std::is_base_of<boost::asio::ip::tcp::socket, T>::value;
 
+template <Socket T>
+class Connection;
+
+// Called on the connection's executor for every request read from the
+// socket, with the header the connection parsed to frame it.
+template <Socket T>
+using RequestHandler = std::function<void(std::shared_ptr<Connection<T>>, message::Request)>;
+
+// Called on the connection's executor with the pieces of a streamed request
+// body, in order, each carrying the sequence number of its request. The
+// last call has last set; its data may be empty.
+template <Socket T>
+using BodyHandler = std::function<void(std::shared_ptr<Connection<T>>, message::Data, bool last)>;
+
+// Deadlines enforced on every connection; a connection that misses one is closed.
+struct Timeouts {
+  // Waiting for the next request while no response is outstanding.
+  std::chrono::milliseconds idle{std::chrono::minutes(5)};
+  // Reading the rest of a request header once its first bytes arrived.
+  std::chrono::milliseconds header{std::chrono::seconds(30)};
+  // Reading a buffered request body; a streamed body restarts it with
+  // every read that makes progress.
+  std::chrono::milliseconds body{std::chrono::seconds(60)};
+  // Each step of writing a response, i.e. the peer has to keep reading.
+  std::chrono::milliseconds write{std::chrono::seconds(60)};
+};
+
+// Caps on the request header a connection buffers. A request over a limit
+// is answered with a static error response and the connection is closed.
+struct Limits {
+  // Request line and header fields, up to the empty line; 431 when exceeded.
+  std::size_t max_header_size{16 * 1024};
+  // Request line alone; 414 when exceeded.
+  std::size_t max_request_line{8 * 1024};
+  // Bodies with a Content-Length up to this size are handed to the request
+  // handler together with their header. Larger and chunked bodies are
+  // streamed to the body handler, or discarded if there is none.
+  std::size_t max_buffered_body{64 * 1024};
+};
+
 template <Socket T>
 class Connection: public std::enable_shared_from_this<Connection<T>> {
 public:
+  using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+
   Connection() = delete;
-  Connection(boost::asio::io_context& io_context, T socket, utils::Queue<message::Data>& in_queue)
-      : _socket(std::move(socket)), _io_context(io_context), _buffer(),
-        _last_active_time(std::chrono::system_clock::now()), _in_queue(in_queue) {}
+  Connection(boost::asio::io_context& io_context, T socket, RequestHandler<T> request_handler)
+      : _socket(std::move(socket)), _io_context(io_context),
+        _strand(boost::asio::make_strand(io_context)), _buffer(),
+        _timers(boost::asio::use_service<reactor::TimerService>(io_context)),
+        _request_handler(std::move(request_handler)) {}
 
   ~Connection() {
     auto ec = finish();
@@ -38,32 +103,188 @@ public:
   std::shared_ptr<Connection> get_shared_ptr() { return this->shared_from_this(); }
 
   const T& socket() const { return _socket; }
+  boost::asio::io_context& io_context() { return _io_context; }
+  // Every operation on the connection runs on this strand.
+  const Strand& executor() const { return _strand; }
   bool is_connected() const { return _socket.is_open(); }
-  bool is_timed_out() const {
-    return std::chrono::system_clock::now() - _last_active_time > std::chrono::minutes(5);
-  }
 
-  bool closable() const { return is_timed_out() || !is_connected(); }
+  bool closable() const { return !is_connected(); }
 
-  void send(const message::Data& data);
+  // Must be called before receive().
+  void set_timeouts(const Timeouts& timeouts) { _timeouts = timeouts; }
+  // Must be called before receive().
+  void set_limits(const Limits& limits) {
+    _limits = limits;
+    _limits.max_header_size = std::max<std::size_t>(_limits.max_header_size, 4);
+    _parser.set_limits(_limits.max_request_line, _limits.max_header_size);
+  }
+  // Once high requests are waiting for their response to be written the
+  // connection stops reading, and resumes when they are down to low.
+  void set_pipeline_watermarks(std::uint32_t high, std::uint32_t low) {
+    _pipeline_high_watermark = std::max(high, 1u);
+    _pipeline_low_watermark = std::min(low, _pipeline_high_watermark - 1);
+  }
+  // Called once, from finish(), when the connection closes. It must not
+  // drop the last reference to the connection synchronously.
+  void set_close_handler(std::function<void()> close_handler) {
+    _close_handler = std::move(close_handler);
+  }
+  // Must be called before receive().
+  void set_body_handler(BodyHandler<T> body_handler) { _body_handler = std::move(body_handler); }
+  // Runs the blocking reads of files copied through the chunk ring, so they
+  // do not stall the reactor; without it they run inline. Must be called
+  // before receive().
+  void set_file_thread_pool(thread::ThreadPool* thread_pool) { _file_thread_pool = thread_pool; }
+  // The pool handle of the connection, see ConnectionPool::handle().
+  std::uint64_t handle() const { return _handle; }
+  void set_handle(std::uint64_t handle) { _handle = handle; }
+
+  // Queues data behind everything already queued for writing. May be
+  // called from any thread; the queue keeps the data alive until written.
+  void send(message::Payload data);
+  // Queues a response for the request with the same sequence number.
+  // Responses are written strictly in request order; may be called from any thread.
+  void deliver(message::Payload response);
   void receive(std::uint32_t connection_id);
   boost::system::error_code finish();
 
 private:
-  void commit(const message::Data& data);
+  // One armed timer of the timer service; epoch tells a stale expiry from the current one.
+  struct Deadline {
+    reactor::TimerService::TimerId timer{reactor::TimingWheel::INVALID_TIMER};
+    std::uint64_t epoch{0};
+  };
+  // Part of the next request being read, each with its own read deadline
+  // that runs from the start of the part, however slowly its bytes arrive.
+  enum class ReadPhase { idle, header, body };
+
+  template <typename Handler>
+  auto bind_strand(Handler&& handler);
+
+  void commit(message::Request request);
+  std::size_t commit_requests(std::uint32_t connection_id);
+  bool stream_body();
+  void reject(message::RequestParser::Error error);
+  void refuse(const std::string& response);
+  void enqueue(message::Payload payload);
+  void release_responses();
+  void start_write();
+  void write_segments();
+  void transmit_file();
+  void start_file_copy();
+  void read_file_chunks();
+  bool finish_file_read(std::size_t chunk, boost::system::error_code ec,
+                        std::size_t bytes_transfered);
+  void write_file_chunk();
+  void complete_segment();
+  void fail_write(boost::system::error_code ec);
+  void cork(bool enable);
+  void arm_deadline(Deadline& deadline, std::chrono::milliseconds timeout, std::string_view name);
+  void cancel_deadline(Deadline& deadline);
+  void handle_timeout(Deadline& deadline, std::uint64_t epoch, std::string_view name);
+  void update_idle_deadline();
+  bool has_pending_responses() const { return _next_response_sequence < _next_request_sequence; }
+  std::uint64_t outstanding_requests() const {
+    return _next_request_sequence - _next_response_sequence + _write_queue.size();
+  }
+  void resume_reading();
 
   boost::system::error_code handle_write(boost::system::error_code ec,
                                          std::size_t bytes_transfered);
+  boost::system::error_code handle_write_queue(boost::system::error_code ec,
+                                               std::size_t bytes_transfered);
+  boost::system::error_code handle_file_read(std::uint64_t epoch, std::size_t chunk,
+                                             boost::system::error_code ec,
+                                             std::size_t bytes_transfered);
+  boost::system::error_code handle_file_write(std::uint64_t epoch, boost::system::error_code ec,
+                                              std::size_t bytes_transfered);
   boost::system::error_code handle_read(std::uint32_t connection_id, boost::system::error_code ec,
                                         std::size_t bytes_transferred);
 
   T _socket;
   boost::asio::io_context& _io_context;
+  Strand _strand;
   boost::asio::streambuf _buffer;
+  // Largest read while a header is incomplete, and while streaming a body.
+  static constexpr std::size_t HEADER_READ_SIZE = 4 * 1024;
+  static constexpr std::size_t BODY_READ_SIZE = 64 * 1024;
+
+  reactor::TimerService& _timers;
+  Timeouts _timeouts{};
+  Limits _limits{};
+  std::uint64_t _handle{0};
+  Deadline _read_deadline{};
+  Deadline _write_deadline{};
+  // Waiting for the first byte of the next request.
+  bool _awaiting_request{false};
+  ReadPhase _read_phase{ReadPhase::idle};
+
+  RequestHandler<T> _request_handler;
+  BodyHandler<T> _body_handler;
+  std::function<void()> _close_handler;
 
-  std::chrono::time_point<std::chrono::system_clock> _last_active_time;
+  // The header at the front of the buffer, parsed as it arrives.
+  message::RequestParser _parser{_limits.max_request_line, _limits.max_header_size};
+  // Body of the request with sequence _body_sequence, streamed as it is read.
+  message::BodyFramer _body_framer{};
+  bool _streaming_body{false};
+  std::uint64_t _body_sequence{0};
+  std::vector<std::string_view> _body_pieces;
 
-  utils::Queue<message::Data>& _in_queue;
+  // Pipelining state: requests are numbered as they are read, responses
+  // wait in _pending_responses until every earlier response has been queued.
+  std::uint64_t _next_request_sequence{0};
+  std::uint64_t _next_response_sequence{0};
+  std::map<std::uint64_t, message::Payload> _pending_responses;
+  std::uint32_t _connection_id{0};
+  std::uint32_t _pipeline_high_watermark{64};
+  std::uint32_t _pipeline_low_watermark{32};
+  bool _read_paused{false};
+
+  // Outgoing queue. Memory segments of consecutive payloads are coalesced
+  // into one gathered write of at most MAX_GATHER_BUFFERS buffers and
+  // MAX_GATHER_BYTES bytes; a file region ends the gather.
+  static constexpr std::size_t MAX_GATHER_BUFFERS = 64;
+  static constexpr std::size_t MAX_GATHER_BYTES = 256 * 1024;
+  std::deque<message::Payload> _write_queue;
+  std::size_t _segment{0};
+  // Position in _write_queue right after the gathered write in flight.
+  std::size_t _gather_payload{0};
+  std::size_t _gather_segment{0};
+  std::vector<boost::asio::const_buffer> _write_buffers;
+  bool _writing{false};
+  bool _read_closed{false};
+  bool _corked{false};
+
+  // Progress of the file region at the front of _write_queue. Files
+  // sendfile(2) cannot handle, and every file when built with io_uring, are
+  // copied through a ring of FILE_CHUNKS chunks instead: reads fill the
+  // chunks ahead of the write, which sends them in order; blocking reads run
+  // on _file_thread_pool if there is one. A transfer never holds more than
+  // FILE_CHUNKS * FILE_CHUNK_SIZE bytes, whatever the file size.
+  static constexpr std::size_t FILE_CHUNK_SIZE = 256 * 1024;
+  static constexpr std::size_t FILE_CHUNKS = 4;
+  struct FileChunk {
+    std::size_t size{0};
+    bool ready{false};
+  };
+  std::uint64_t _file_sent{0};
+  bool _sendfile_unsupported{false};
+  // Bytes of the region whose read has been started.
+  std::uint64_t _file_read{0};
+  // The next chunk to write, and how many chunks from it are read or being read.
+  std::size_t _file_chunk_head{0};
+  std::size_t _file_chunks_used{0};
+  bool _file_writing{false};
+  // Tells completions of a failed copy from those of the current one.
+  std::uint64_t _file_epoch{0};
+  std::array<FileChunk, FILE_CHUNKS> _file_chunks{};
+  // Shared with the reads and writes in flight, which may outlive the copy.
+  std::shared_ptr<std::uint8_t[]> _file_buffer;
+  thread::ThreadPool* _file_thread_pool{nullptr};
+#ifdef USE_IO_URING
+  std::optional<boost::asio::random_access_file> _file_stream;
+#endif
 };
 
 } // namespace connection
@@ -74,104 +295,422 @@ namespace web_server {
 namespace connection {
 
 template <Socket T>
-void Connection<T>::send(const message::Data& data) {
+template <typename Handler>
+auto Connection<T>::bind_strand(Handler&& handler) {
+  // Keeps a shared connection alive until the handler has run.
+  return boost::asio::bind_executor(
+      _strand, [self = this->weak_from_this().lock(),
+                handler = std::forward<Handler>(handler)](auto&&... args) mutable {
+        handler(std::forward<decltype(args)>(args)...);
+      });
+}
+
+template <Socket T>
+void Connection<T>::send(message::Payload data) {
   utils::Logger::logger().info("Connection send data");
 #ifdef DEBUG
-  utils::Logger::logger().debug("Connection send data: " + data.to_string());
   utils::Logger::logger().debug("Connection send data size: " + std::to_string(data.size()));
 #endif
-  try {
-    boost::asio::async_write(
-        _socket, boost::asio::buffer(reinterpret_cast<const void*>(data.data()), data.size()),
-        std::bind(&Connection::handle_write, get_shared_ptr(), std::placeholders::_1,
-                  std::placeholders::_2));
-  } catch (const std::bad_weak_ptr& e) {
-    boost::asio::async_write(
-        _socket, boost::asio::buffer(reinterpret_cast<const void*>(data.data()), data.size()),
-        std::bind(&Connection::handle_write, this, std::placeholders::_1, std::placeholders::_2));
+  boost::asio::dispatch(_strand, [this, self = this->weak_from_this().lock(),
+                                  data = std::move(data)]() mutable {
+    enqueue(std::move(data));
+    start_write();
+  });
+}
+
+template <Socket T>
+void Connection<T>::deliver(message::Payload response) {
+#ifdef DEBUG
+  utils::Logger::logger().debug("Connection deliver response sequence: " +
+                                std::to_string(response.sequence()));
+#endif
+  boost::asio::dispatch(_strand, [this, self = this->weak_from_this().lock(),
+                                  response = std::move(response)]() mutable {
+    auto sequence = response.sequence();
+    _pending_responses.emplace(sequence, std::move(response));
+    release_responses();
+    start_write();
+  });
+}
+
+template <Socket T>
+void Connection<T>::enqueue(message::Payload payload) {
+  if (is_connected() && !payload.segments().empty()) {
+    _write_queue.push_back(std::move(payload));
+  }
+}
+
+// Moves every response whose predecessors have all been queued to the write queue.
+template <Socket T>
+void Connection<T>::release_responses() {
+  auto it = _pending_responses.find(_next_response_sequence);
+  while (it != _pending_responses.end()) {
+    enqueue(std::move(it->second));
+    _pending_responses.erase(it);
+    it = _pending_responses.find(++_next_response_sequence);
   }
 }
 
+template <Socket T>
+void Connection<T>::resume_reading() {
+#ifdef DEBUG
+  utils::Logger::logger().debug("Connection resume reading");
+#endif
+  _read_paused = false;
+  // Commits the requests left in the buffer before reading on.
+  handle_read(_connection_id, {}, 0);
+}
+
+template <Socket T>
+void Connection<T>::start_write() {
+  if (_writing) {
+    return;
+  }
+
+  if (!_write_queue.empty()) {
+    _writing = true;
+    write_segments();
+    return;
+  }
+
+  if (_read_closed && !has_pending_responses()) {
+    auto ec = finish();
+    if (ec) {
+      utils::Logger::logger().error("Connection Finish Error: " + ec.message());
+    }
+  }
+}
+
+template <Socket T>
+void Connection<T>::write_segments() {
+  while (!_write_queue.empty() && _segment == _write_queue.front().segments().size()) {
+    _write_queue.pop_front();
+    _segment = 0;
+  }
+  if (_read_paused && outstanding_requests() <= _pipeline_low_watermark && is_connected()) {
+    resume_reading();
+  }
+
+  if (_write_queue.empty()) {
+    // Everything queued has been written; drop per-write state until the next response.
+    _writing = false;
+    _write_buffers.clear();
+    cork(false);
+    cancel_deadline(_write_deadline);
+    update_idle_deadline();
+    _file_buffer.reset();
+    start_write();
+    return;
+  }
+
+  arm_deadline(_write_deadline, _timeouts.write, "write");
+  const auto& segments = _write_queue.front().segments();
+  if (auto region = std::get_if<message::FileRegion>(&segments[_segment])) {
+    _file_sent = 0;
+#ifdef USE_IO_URING
+    _sendfile_unsupported = true;
+#else
+    _sendfile_unsupported = !region->file().is_regular();
+#endif
+    transmit_file();
+    return;
+  }
+
+  // Gather memory segments up to the next file region, across queued
+  // payloads, into one write.
+  _write_buffers.clear();
+  std::size_t bytes = 0;
+  std::size_t payload = 0;
+  std::size_t segment = _segment;
+  bool file_follows = false;
+  while (payload < _write_queue.size() && _write_buffers.size() < MAX_GATHER_BUFFERS &&
+         bytes < MAX_GATHER_BYTES) {
+    const auto& payload_segments = _write_queue[payload].segments();
+    if (segment == payload_segments.size()) {
+      ++payload;
+      segment = 0;
+      continue;
+    }
+    auto buffer = std::get_if<message::Buffer>(&payload_segments[segment]);
+    if (buffer == nullptr) {
+      file_follows = true;
+      break;
+    }
+    _write_buffers.emplace_back(buffer->data(), buffer->size());
+    bytes += buffer->size();
+    ++segment;
+  }
+  _gather_payload = payload;
+  _gather_segment = segment;
+  if (file_follows) {
+    // Hold the header back until the file region follows it, otherwise
+    // Nagle's algorithm delays the small trailing segment of small files.
+    cork(true);
+  }
+
+  boost::asio::async_write(_socket, _write_buffers,
+                           bind_strand(std::bind(&Connection::handle_write_queue, this,
+                                                 std::placeholders::_1, std::placeholders::_2)));
+}
+
 template <Socket T>
 void Connection<T>::receive(std::uint32_t connection_id) {
   utils::Logger::logger().info("Connection " + std::to_string(connection_id) + " receive data ");
-  try {
-    boost::asio::async_read_until(_socket, _buffer, "\r\n\r\n",
-                                  std::bind(&Connection::handle_read, get_shared_ptr(),
-                                            connection_id, std::placeholders::_1,
-                                            std::placeholders::_2));
-  } catch (const std::bad_weak_ptr& e) {
-    boost::asio::async_read_until(_socket, _buffer, "\r\n\r\n",
-                                  std::bind(&Connection::handle_read, this, connection_id,
-                                            std::placeholders::_1, std::placeholders::_2));
+  _connection_id = connection_id;
+  if (_buffer.size() == 0) {
+    // Nothing of the next request has arrived yet, the connection is idle.
+    _awaiting_request = true;
+    _read_phase = ReadPhase::idle;
+    update_idle_deadline();
+    boost::asio::async_read(_socket, _buffer, boost::asio::transfer_at_least(1),
+                            bind_strand(std::bind(&Connection::handle_read, this, connection_id,
+                                                  std::placeholders::_1, std::placeholders::_2)));
+    return;
+  }
+
+  if (_read_phase != ReadPhase::header) {
+    _read_phase = ReadPhase::header;
+    arm_deadline(_read_deadline, _timeouts.header, "header");
   }
+  // The buffer only holds the incomplete header here, which commit_requests()
+  // keeps below the limit, so reading at most up to the limit bounds it.
+  auto size = std::min(_limits.max_header_size - _buffer.size(), HEADER_READ_SIZE);
+  _socket.async_read_some(_buffer.prepare(size),
+                          bind_strand([this, connection_id](boost::system::error_code ec,
+                                                            std::size_t bytes_transferred) {
+                            _buffer.commit(bytes_transferred);
+                            handle_read(connection_id, ec, bytes_transferred);
+                          }));
 }
 
 template <Socket T>
 boost::system::error_code Connection<T>::finish() {
+  cancel_deadline(_read_deadline);
+  cancel_deadline(_write_deadline);
   boost::system::error_code ec;
   _socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
   _socket.close(ec);
   _buffer.consume(_buffer.size());
+  if (_close_handler) {
+    auto close_handler = std::move(_close_handler);
+    _close_handler = nullptr;
+    close_handler();
+  }
   utils::Logger::logger().info("Connection Closed");
   return ec;
 }
 
 template <Socket T>
-void Connection<T>::commit(const message::Data& data) {
-  _in_queue.push(std::move(data));
+void Connection<T>::commit(message::Request request) {
+  _request_handler(get_shared_ptr(), std::move(request));
 }
 
+// Commits every complete request sitting in the buffer, in order, and
+// streams the body of the last one if it is too large to buffer. Returns
+// how many more bytes are needed to get on, or 0 if the buffer holds no
+// complete header.
 template <Socket T>
-boost::system::error_code Connection<T>::handle_read(std::uint32_t connection_id,
-                                                     boost::system::error_code ec,
-                                                     std::size_t bytes_transferred) {
-  if (!ec) {
-    message::Data data{};
-    data.set_connection_id(connection_id);
-
-    message::DataBuffer data_buffer{(char*)_buffer.data().data(), bytes_transferred};
+std::size_t Connection<T>::commit_requests(std::uint32_t connection_id) {
+  while (true) {
+    if (_streaming_body) {
+      if (!stream_body()) {
+        return 1;
+      }
+      continue;
+    }
+    if (outstanding_requests() >= _pipeline_high_watermark) {
+      // Leave the rest in the buffer and stop reading until responses drain.
+      _read_paused = true;
+      return 0;
+    }
+    std::string_view buffered{static_cast<const char*>(_buffer.data().data()), _buffer.size()};
+    auto status = _parser.parse(buffered);
+    if (status == message::RequestParser::Status::error) {
+      reject(_parser.error());
+      return 0;
+    }
+    if (status == message::RequestParser::Status::incomplete) {
+      return 0;
+    }
 
-    std::istream is(dynamic_cast<std::streambuf*>(&data_buffer));
-    std::string line{};
-    std::uint32_t length = bytes_transferred;
-    while (std::getline(is, line) && line != "\r") {
-#ifdef DEBUG
-      utils::Logger::logger().debug("Connection read line: " + line);
-#endif
-      if (line.find("Content-Length") != std::string::npos) {
-        std::string_view key, value;
-        utils::split_head(line, key, value);
-        length += std::stoi(std::string(value));
-#ifdef DEBUG
-        utils::Logger::logger().debug("Connection Read Content-Length: " + std::string(value));
-        utils::Logger::logger().debug("Connection Total Length: " + std::to_string(length));
-#endif
-        break;
+    std::size_t header_size = _parser.header_size();
+    if (!_body_framer.start(_parser)) {
+      utils::Logger::logger().warning("Connection malformed body framing, refusing request");
+      refuse(assets::BAD_REQUEST_RESPONSE);
+      return 0;
+    }
+    std::size_t length = header_size;
+    auto framing = _body_framer.framing();
+    if (framing == message::BodyFramer::Framing::length &&
+        _body_framer.content_length() <= _limits.max_buffered_body) {
+      length += _body_framer.content_length();
+      if (length > buffered.size()) {
+        return length - buffered.size();
       }
+      framing = message::BodyFramer::Framing::none;
     }
 
-    data.append((std::uint8_t*)_buffer.data().data(), length);
+    message::Data data(reinterpret_cast<const std::uint8_t*>(buffered.data()), length,
+                       connection_id);
+    data.set_sequence(_next_request_sequence++);
 #ifdef DEBUG
-    utils::Logger::logger().debug(
-        "Connection Read: " + std::string{reinterpret_cast<const char*>(data.data()), data.size()});
+    utils::Logger::logger().debug("Connection Read: " + data.to_string());
 #endif
-    commit(data);
+    message::Request request(std::move(data), _parser);
     _buffer.consume(length);
-    _last_active_time = std::chrono::system_clock::now();
+    _parser.reset();
+    _read_phase = ReadPhase::idle;
+    if (framing != message::BodyFramer::Framing::none) {
+      _streaming_body = true;
+      _body_sequence = request.sequence();
+    }
     utils::Logger::logger().info("Connection Read " + std::to_string(length) + " bytes");
+    commit(std::move(request));
+  }
+}
+
+// Hands the body bytes in the buffer to the body handler and drops them.
+// Returns true once the body is complete.
+template <Socket T>
+bool Connection<T>::stream_body() {
+  std::string_view buffered{static_cast<const char*>(_buffer.data().data()), _buffer.size()};
+  std::size_t consumed = 0;
+  _body_pieces.clear();
+  auto status = _body_framer.decode(buffered, consumed, _body_pieces);
+  if (status == message::BodyFramer::Status::error) {
+    utils::Logger::logger().warning("Connection malformed request body, refusing request");
+    _streaming_body = false;
+    refuse(assets::BAD_REQUEST_RESPONSE);
+    return false;
+  }
+
+  auto last = status == message::BodyFramer::Status::complete;
+  std::size_t size = 0;
+  for (auto piece : _body_pieces) {
+    size += piece.size();
+  }
+  if (_body_handler && (size > 0 || last)) {
+    message::Data chunk(size, _connection_id);
+    for (auto piece : _body_pieces) {
+      chunk.append(reinterpret_cast<const std::uint8_t*>(piece.data()), piece.size());
+    }
+    chunk.set_sequence(_body_sequence);
+    _body_handler(get_shared_ptr(), std::move(chunk), last);
+  }
+  _buffer.consume(consumed);
+  if (last) {
+    _streaming_body = false;
+    _read_phase = ReadPhase::idle;
+  }
+  return last;
+}
+
+// Refuses the request at the front of the buffer, whose header is
+// malformed or over the limits.
+template <Socket T>
+void Connection<T>::reject(message::RequestParser::Error error) {
+  using Error = message::RequestParser::Error;
+  switch (error) {
+  case Error::uri_too_long:
+    utils::Logger::logger().warning("Connection request line too long, refusing request");
+    refuse(assets::URI_TOO_LONG_RESPONSE);
+    break;
+  case Error::header_fields_too_large:
+    utils::Logger::logger().warning("Connection request header too large, refusing request");
+    refuse(assets::REQUEST_HEADER_FIELDS_TOO_LARGE_RESPONSE);
+    break;
+  case Error::not_implemented:
+    utils::Logger::logger().warning("Connection unknown request method, refusing request");
+    refuse(assets::NOT_IMPLEMENTED_RESPONSE);
+    break;
+  case Error::version_not_supported:
+    utils::Logger::logger().warning("Connection unsupported HTTP version, refusing request");
+    refuse(assets::HTTP_VERSION_NOT_SUPPORTED_RESPONSE);
+    break;
+  case Error::none:
+  case Error::bad_request:
+    utils::Logger::logger().warning("Connection malformed request header, refusing request");
+    refuse(assets::BAD_REQUEST_RESPONSE);
+    break;
+  }
+}
+
+// Answers the request being read with a static response, in order after
+// the responses still outstanding, then closes the connection.
+template <Socket T>
+void Connection<T>::refuse(const std::string& response) {
+  message::Payload payload{_connection_id};
+  payload.append(message::Buffer::view(response));
+  payload.set_sequence(_next_request_sequence++);
+  _read_closed = true;
+  _buffer.consume(_buffer.size());
+  cancel_deadline(_read_deadline);
+  _pending_responses.emplace(payload.sequence(), std::move(payload));
+  release_responses();
+  start_write();
+}
+
+template <Socket T>
+boost::system::error_code
+Connection<T>::handle_read(std::uint32_t connection_id, boost::system::error_code ec,
+                           [[maybe_unused]] std::size_t bytes_transferred) {
+  _awaiting_request = false;
+  if (!ec) {
+    auto missing = commit_requests(connection_id);
+    if (_read_closed) {
+      // A request was refused; the connection closes once it is answered.
+      return ec;
+    }
+    if (_read_paused) {
+      cancel_deadline(_read_deadline);
+      return ec;
+    }
+    if (missing == 0) {
+      receive(connection_id);
+      return ec;
+    }
 
-    receive(connection_id);
+    if (_streaming_body) {
+      // Read the body a bounded piece at a time, however large it is.
+      _read_phase = ReadPhase::body;
+      arm_deadline(_read_deadline, _timeouts.body, "body");
+      _socket.async_read_some(_buffer.prepare(BODY_READ_SIZE),
+                              bind_strand([this, connection_id](boost::system::error_code ec,
+                                                                std::size_t bytes_transferred) {
+                                _buffer.commit(bytes_transferred);
+                                handle_read(connection_id, ec, bytes_transferred);
+                              }));
+      return ec;
+    }
+    if (_read_phase != ReadPhase::body) {
+      _read_phase = ReadPhase::body;
+      arm_deadline(_read_deadline, _timeouts.body, "body");
+    }
+    boost::asio::async_read(_socket, _buffer, boost::asio::transfer_at_least(missing),
+                            bind_strand(std::bind(&Connection::handle_read, this, connection_id,
+                                                  std::placeholders::_1, std::placeholders::_2)));
   } else {
+    cancel_deadline(_read_deadline);
     if (ec == boost::asio::error::eof) {
+      if (has_pending_responses() || _writing) {
+        // The client may half-close after pipelining; answer everything first.
+        _read_closed = true;
+        return ec;
+      }
       utils::Logger::logger().warning("Connection End of File, trying to close");
       auto finish_ec = finish();
       if (finish_ec) {
         utils::Logger::logger().error("Connection Finish Error: " + finish_ec.message());
         std::exit(1);
       }
-    } else {
+    } else if (ec != boost::asio::error::operation_aborted) {
+      // The connection was reset or broke; nothing more can be read or
+      // written, so close it and give its pool slot back.
       utils::Logger::logger().error("Connection Read Error: " + ec.message());
+      auto finish_ec = finish();
+      if (finish_ec) {
+        utils::Logger::logger().error("Connection Finish Error: " + finish_ec.message());
+      }
     }
   }
 
@@ -181,7 +720,6 @@ boost::system::error_code Connection<T>::handle_read(std::uint32_t connection_id
 template <Socket T>
 boost::system::error_code Connection<T>::handle_write(boost::system::error_code ec,
                                                       std::size_t bytes_transfered) {
-  _last_active_time = std::chrono::system_clock::now();
   if (!ec) {
     utils::Logger::logger().info("Connection Write " + std::to_string(bytes_transfered) + " bytes");
   } else {
@@ -190,6 +728,317 @@ boost::system::error_code Connection<T>::handle_write(boost::system::error_code
   return ec;
 }
 
+template <Socket T>
+boost::system::error_code Connection<T>::handle_write_queue(boost::system::error_code ec,
+                                                            std::size_t bytes_transfered) {
+  handle_write(ec, bytes_transfered);
+  if (ec) {
+    fail_write(ec);
+    return ec;
+  }
+  // Release the payloads the gathered write has completed.
+  _write_queue.erase(_write_queue.begin(), _write_queue.begin() + _gather_payload);
+  _segment = _gather_segment;
+  write_segments();
+  return ec;
+}
+
+template <Socket T>
+void Connection<T>::transmit_file() {
+  const auto& region = std::get<message::FileRegion>(_write_queue.front().segments()[_segment]);
+  while (_file_sent < region.length()) {
+    if (_sendfile_unsupported) {
+      start_file_copy();
+      return;
+    }
+
+    std::error_code error;
+    _socket.native_non_blocking(true);
+    _file_sent += region.send_to(_socket.native_handle(), _file_sent, error);
+    if (error == std::errc::resource_unavailable_try_again ||
+        error == std::errc::operation_would_block) {
+      // Socket send buffer is full, wait until it drains.
+      _socket.async_wait(boost::asio::ip::tcp::socket::wait_write,
+                         bind_strand([this](boost::system::error_code ec) {
+                           if (ec) {
+                             fail_write(ec);
+                           } else {
+                             arm_deadline(_write_deadline, _timeouts.write, "write");
+                             transmit_file();
+                           }
+                         }));
+      return;
+    } else if (error == std::errc::invalid_argument ||
+               error == std::errc::function_not_supported ||
+               error == std::errc::operation_not_supported) {
+      _sendfile_unsupported = true;
+    } else if (error) {
+      utils::Logger::logger().error("Connection Sendfile Error: " + error.message());
+      fail_write(boost::system::error_code(error.value(), boost::system::system_category()));
+      return;
+    }
+  }
+
+  utils::Logger::logger().info("Connection Write " + std::to_string(_file_sent) + " file bytes");
+  complete_segment();
+}
+
+// Copies the rest of the region through the chunk ring.
+template <Socket T>
+void Connection<T>::start_file_copy() {
+  _file_read = _file_sent;
+  _file_chunk_head = 0;
+  _file_chunks_used = 0;
+  _file_writing = false;
+  ++_file_epoch;
+  if (!_file_buffer) {
+    _file_buffer.reset(new std::uint8_t[FILE_CHUNKS * FILE_CHUNK_SIZE]);
+  }
+  read_file_chunks();
+}
+
+// Starts reading into every free chunk, then writes the next one if it is ready.
+template <Socket T>
+void Connection<T>::read_file_chunks() {
+  const auto& region = std::get<message::FileRegion>(_write_queue.front().segments()[_segment]);
+#ifdef USE_IO_URING
+  // The reads are submitted to the same io_uring as the socket operations.
+  if (!_file_stream) {
+    int fd = ::dup(region.file().fd());
+    if (fd < 0) {
+      fail_write(boost::system::error_code(errno, boost::system::system_category()));
+      return;
+    }
+    _file_stream.emplace(_socket.get_executor(), fd);
+  }
+#endif
+  while (_file_chunks_used < FILE_CHUNKS && _file_read < region.length()) {
+    auto chunk = (_file_chunk_head + _file_chunks_used) % FILE_CHUNKS;
+    auto size = static_cast<std::size_t>(
+        std::min<std::uint64_t>(FILE_CHUNK_SIZE, region.length() - _file_read));
+    auto data = _file_buffer.get() + chunk * FILE_CHUNK_SIZE;
+    auto offset = _file_read;
+    _file_chunks[chunk] = FileChunk{size, false};
+    ++_file_chunks_used;
+    _file_read += size;
+#ifdef USE_IO_URING
+    boost::asio::async_read_at(
+        *_file_stream, region.offset() + offset, boost::asio::buffer(data, size),
+        bind_strand([this, buffer = _file_buffer, epoch = _file_epoch, chunk](
+                        boost::system::error_code ec, std::size_t bytes_transfered) {
+          handle_file_read(epoch, chunk, ec, bytes_transfered);
+        }));
+#else
+    auto read_chunk = [region, data, offset, size]() {
+      std::error_code error;
+      std::size_t read = 0;
+      while (!error && read < size) {
+        read += region.read(offset + read, data + read, size - read, error);
+      }
+      return std::pair{boost::system::error_code(error.value(), boost::system::system_category()),
+                       read};
+    };
+    if (_file_thread_pool != nullptr) {
+      // The chunk completes on the strand like an asynchronous read.
+      auto handler = bind_strand([this, buffer = _file_buffer, epoch = _file_epoch, chunk](
+                                     boost::system::error_code ec, std::size_t bytes_transfered) {
+        handle_file_read(epoch, chunk, ec, bytes_transfered);
+      });
+      _file_thread_pool->push_task([read_chunk, handler]() {
+        auto [ec, read] = read_chunk();
+        auto executor = boost::asio::get_associated_executor(handler);
+        boost::asio::post(executor, [handler, ec, read]() mutable { handler(ec, read); });
+      });
+      continue;
+    }
+    auto [ec, read] = read_chunk();
+    if (!finish_file_read(chunk, ec, read)) {
+      return;
+    }
+#endif
+  }
+  write_file_chunk();
+}
+
+// Marks a chunk as read. Returns false if the read failed and the write
+// queue was dropped.
+template <Socket T>
+bool Connection<T>::finish_file_read(std::size_t chunk, boost::system::error_code ec,
+                                     std::size_t bytes_transfered) {
+  if (!ec && bytes_transfered < _file_chunks[chunk].size) {
+    // The file shrank after the response header was generated.
+    ec = boost::asio::error::eof;
+  }
+  if (ec) {
+    utils::Logger::logger().error("Connection File Read Error: " + ec.message());
+    fail_write(ec);
+    return false;
+  }
+  _file_chunks[chunk].ready = true;
+  return true;
+}
+
+template <Socket T>
+boost::system::error_code Connection<T>::handle_file_read(std::uint64_t epoch, std::size_t chunk,
+                                                          boost::system::error_code ec,
+                                                          std::size_t bytes_transfered) {
+  if (epoch != _file_epoch) {
+    return ec;
+  }
+  if (finish_file_read(chunk, ec, bytes_transfered)) {
+    write_file_chunk();
+  }
+  return ec;
+}
+
+template <Socket T>
+void Connection<T>::write_file_chunk() {
+  const auto& chunk = _file_chunks[_file_chunk_head];
+  if (_file_writing || _file_chunks_used == 0 || !chunk.ready) {
+    return;
+  }
+  _file_writing = true;
+  boost::asio::async_write(
+      _socket,
+      boost::asio::buffer(_file_buffer.get() + _file_chunk_head * FILE_CHUNK_SIZE, chunk.size),
+      bind_strand([this, buffer = _file_buffer, epoch = _file_epoch](
+                      boost::system::error_code ec, std::size_t bytes_transfered) {
+        handle_file_write(epoch, ec, bytes_transfered);
+      }));
+}
+
+template <Socket T>
+boost::system::error_code Connection<T>::handle_file_write(std::uint64_t epoch,
+                                                           boost::system::error_code ec,
+                                                           std::size_t bytes_transfered) {
+  if (epoch != _file_epoch) {
+    return ec;
+  }
+  _file_writing = false;
+  if (ec) {
+    utils::Logger::logger().error("Connection Write Error: " + ec.message());
+    fail_write(ec);
+    return ec;
+  }
+  _file_sent += bytes_transfered;
+  _file_chunks[_file_chunk_head].ready = false;
+  _file_chunk_head = (_file_chunk_head + 1) % FILE_CHUNKS;
+  --_file_chunks_used;
+  arm_deadline(_write_deadline, _timeouts.write, "write");
+
+  const auto& region = std::get<message::FileRegion>(_write_queue.front().segments()[_segment]);
+  if (_file_sent == region.length()) {
+    utils::Logger::logger().info("Connection Write " + std::to_string(_file_sent) +
+                                 " file bytes");
+    complete_segment();
+    return ec;
+  }
+  read_file_chunks();
+  return ec;
+}
+
+template <Socket T>
+void Connection<T>::complete_segment() {
+#ifdef USE_IO_URING
+  _file_stream.reset();
+#endif
+  ++_segment;
+  write_segments();
+}
+
+// A failed write leaves the byte stream in an unknown state, so nothing
+// queued after it can be sent; close the connection.
+template <Socket T>
+void Connection<T>::fail_write([[maybe_unused]] boost::system::error_code ec) {
+#ifdef DEBUG
+  utils::Logger::logger().debug("Connection drop write queue: " + ec.message());
+#endif
+  _writing = false;
+  _write_queue.clear();
+  _pending_responses.clear();
+  _segment = 0;
+  _write_buffers.clear();
+  _file_writing = false;
+  _file_chunks_used = 0;
+  ++_file_epoch;
+  _file_buffer.reset();
+#ifdef USE_IO_URING
+  _file_stream.reset();
+#endif
+  auto finish_ec = finish();
+  if (finish_ec) {
+    utils::Logger::logger().error("Connection Finish Error: " + finish_ec.message());
+  }
+}
+
+// Linux only; elsewhere the header and the file go out as they are.
+template <Socket T>
+void Connection<T>::cork([[maybe_unused]] bool enable) {
+#ifdef TCP_CORK
+  if (_corked == enable) {
+    return;
+  }
+  _corked = enable;
+  boost::system::error_code ec;
+  _socket.set_option(boost::asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_CORK>(enable),
+                     ec);
+#endif
+}
+
+template <Socket T>
+void Connection<T>::arm_deadline(Deadline& deadline, std::chrono::milliseconds timeout,
+                                 std::string_view name) {
+  cancel_deadline(deadline);
+  auto epoch = deadline.epoch;
+  deadline.timer = _timers.schedule(
+      timeout, [this, connection = this->weak_from_this(), &deadline, epoch, name]() {
+        // The timer service does not keep connections alive.
+        if (auto self = connection.lock()) {
+          boost::asio::post(_strand, [this, self, &deadline, epoch, name]() {
+            handle_timeout(deadline, epoch, name);
+          });
+        }
+      });
+}
+
+template <Socket T>
+void Connection<T>::cancel_deadline(Deadline& deadline) {
+  if (deadline.timer != reactor::TimingWheel::INVALID_TIMER) {
+    _timers.cancel(deadline.timer);
+    deadline.timer = reactor::TimingWheel::INVALID_TIMER;
+  }
+  ++deadline.epoch;
+}
+
+template <Socket T>
+void Connection<T>::handle_timeout(Deadline& deadline, std::uint64_t epoch,
+                                   std::string_view name) {
+  if (deadline.epoch != epoch) {
+    // Re-armed or cancelled while the expiry was queued.
+    return;
+  }
+  deadline.timer = reactor::TimingWheel::INVALID_TIMER;
+  utils::Logger::logger().warning("Connection " + std::string(name) + " timeout, closing");
+  auto ec = finish();
+  if (ec) {
+    utils::Logger::logger().error("Connection Finish Error: " + ec.message());
+  }
+}
+
+// The idle deadline only runs while the connection waits for a request and
+// owes the client nothing; a slow handler or a long download is not idle.
+template <Socket T>
+void Connection<T>::update_idle_deadline() {
+  if (!_awaiting_request) {
+    return;
+  }
+  if (has_pending_responses() || _writing) {
+    cancel_deadline(_read_deadline);
+  } else {
+    arm_deadline(_read_deadline, _timeouts.idle, "idle");
+  }
+}
+
 } // namespace connection
 } // namespace web_server
 
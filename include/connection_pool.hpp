@@ -4,10 +4,12 @@
 #include "connection.hpp"
 #include "logger.hpp"
 
+#include <array>
+#include <atomic>
+#include <limits>
 #include <memory>
-#include <set>
 #include <string>
-#include <vector>
+#include <thread>
 
 namespace web_server {
 namespace connection {
@@ -19,51 +21,114 @@ using ConnectionPtr = std::shared_ptr<Connection<T>>;
 using TcpConnection = Connection<boost::asio::ip::tcp::socket>;
 using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
 
+// Names one connection for its whole life: the slot id in the low half and
+// the slot's generation in the high half. Erasing a connection bumps the
+// generation, so its handles stay invalid after the slot is reused.
+using ConnectionHandle = std::uint64_t;
+
+// Fixed capacity table of connections, indexed by id.
+//
+// Every operation may be called from any thread. Free ids are kept on a
+// lock-free stack (tagged against ABA) threaded through the slots, ids that
+// were never used are handed out from a counter, and slot storage is
+// allocated in chunks the first time an id in the chunk is used. Each slot
+// publishes a raw pointer, so lookup by id is one atomic load; the owning
+// reference sits beside it and is only touched by the thread that stored or
+// erased the connection. erase_all() and clear() must not race other calls.
+//
+// Ids are reused as soon as a connection is erased. Work that outlives a
+// request should hold a handle instead and look the connection up again.
 template <Socket T>
 class ConnectionPool {
 public:
   ConnectionPool();
   ConnectionPool(std::uint32_t max_connections);
+  ConnectionPool(const ConnectionPool&) = delete;
+  ConnectionPool& operator=(const ConnectionPool&) = delete;
 
-  ~ConnectionPool() = default;
+  ~ConnectionPool() { clear(); }
 
   std::int32_t add(const ConnectionPtr<T> connection);
-  std::int32_t emplace(boost::asio::io_context& io_context, T socket,
-                       utils::Queue<message::Data>& in_queue);
+  // The socket is only moved from if a connection was created.
+  std::int32_t emplace(boost::asio::io_context& io_context, T&& socket,
+                       RequestHandler<T> request_handler);
 
-  void erase(std::int32_t id) {
-    _connections[id] = nullptr;
-    _available_ids.insert(id);
-  }
+  void erase(std::int32_t id);
+  // Does nothing if the connection was already erased.
+  void erase(ConnectionHandle handle);
 
+  // Only for the thread that stored the connection under id, or the one
+  // that erases it: nothing else keeps it alive during the call.
   ConstConnectionPtr<T> get_connection(std::int32_t id) const {
-    if (id >= _max_connections) {
-      return nullptr;
-    }
-    return _connections[id];
+    auto slot = find_slot(id);
+    auto connection = slot ? slot->load(std::memory_order_acquire) : nullptr;
+    return connection ? connection->shared_from_this() : nullptr;
   }
 
   ConnectionPtr<T> get_connection(std::int32_t id) {
-    if (id >= _max_connections) {
-      return nullptr;
-    }
-    return _connections[id];
+    auto slot = find_slot(id);
+    auto connection = slot ? slot->load(std::memory_order_acquire) : nullptr;
+    return connection ? connection->get_shared_ptr() : nullptr;
   }
 
+  // Handle of the connection currently stored under id.
+  ConnectionHandle handle(std::int32_t id) const;
+  // Returns nullptr if the connection was erased. Safe from any thread: the
+  // slot is pinned while the reference is taken, and erasing waits for pins
+  // before it drops the pool's reference.
+  ConnectionPtr<T> get_connection(ConnectionHandle handle);
+  // The same lookup without sharing ownership or pinning the slot. The
+  // connection may only be used on a thread that is the only one to erase
+  // it, i.e. its reactor, where it cannot be destroyed during the call.
+  Connection<T>* resolve(ConnectionHandle handle) const;
+  bool is_valid(ConnectionHandle handle) const;
+
   void erase_all();
   void clear();
 
+  // Erases every connection whose socket is closed. It inspects sockets
+  // owned by other threads, so it must not race their reactors.
   std::size_t erase_unavaliable();
 
-  bool is_empty() const { return _available_ids.size() == _max_connections; }
-  bool is_full() const { return _available_ids.empty(); }
-  std::uint32_t size() const { return _max_connections - _available_ids.size(); }
+  bool is_empty() const { return size() == 0; }
+  bool is_full() const { return size() >= _max_connections; }
+  std::uint32_t size() const { return _size.load(std::memory_order_relaxed); }
   std::uint32_t max_size() const { return _max_connections; }
 
 private:
+  static constexpr std::uint32_t CHUNK_SIZE = 1024;
+  static constexpr std::uint32_t NIL = std::numeric_limits<std::uint32_t>::max();
+
+  using Slot = std::atomic<Connection<T>*>;
+
+  struct Chunk {
+    std::array<Slot, CHUNK_SIZE> connections{};
+    // The pool's reference to what connections points at. Written by the
+    // thread that allocated the id or won the erase, never read elsewhere.
+    std::array<ConnectionPtr<T>, CHUNK_SIZE> owners{};
+    std::array<std::atomic<std::uint32_t>, CHUNK_SIZE> generations{};
+    // Lookups by handle in progress, see get_connection(ConnectionHandle).
+    std::array<std::atomic<std::uint32_t>, CHUNK_SIZE> pins{};
+    // Next id on the free stack, valid while the slot is free.
+    std::array<std::atomic<std::uint32_t>, CHUNK_SIZE> next{};
+  };
+
+  Slot* find_slot(std::int32_t id) const;
+  Chunk& chunk(std::uint32_t id);
+  const std::atomic<std::uint32_t>* find_generation(std::int32_t id) const;
+  void retire(std::uint32_t id);
+  void unpin(std::uint32_t id);
+  std::int32_t allocate();
+  void release(std::uint32_t id);
+  std::int32_t store(std::int32_t id, ConnectionPtr<T> connection);
+
   std::uint32_t _max_connections;
-  std::vector<ConnectionPtr<T>> _connections;
-  std::set<std::int32_t> _available_ids;
+  std::unique_ptr<std::atomic<Chunk*>[]> _chunks;
+  // Top of the free stack: a tag counting pushes and pops in the high half, the id in the low one.
+  std::atomic<std::uint64_t> _free_head{NIL};
+  // Ids at and above it have never been used.
+  std::atomic<std::uint32_t> _next_unused{0};
+  std::atomic<std::uint32_t> _size{0};
 };
 
 } // namespace connection
@@ -74,32 +139,40 @@ namespace web_server {
 namespace connection {
 
 template <Socket T>
-ConnectionPool<T>::ConnectionPool()
-    : _max_connections(std::numeric_limits<std::uint16_t>::max()),
-      _connections(_max_connections, nullptr) {
-  for (std::uint32_t i = 0; i < _max_connections; ++i) {
-    _available_ids.insert(i);
-  }
-}
+ConnectionPool<T>::ConnectionPool(): ConnectionPool(std::numeric_limits<std::uint16_t>::max()) {}
 
 template <Socket T>
 ConnectionPool<T>::ConnectionPool(std::uint32_t max_connections)
-    : _max_connections(max_connections), _connections(max_connections, nullptr) {
-  for (std::uint32_t i = 0; i < _max_connections; ++i) {
-    _available_ids.insert(i);
+    : _max_connections(max_connections),
+      _chunks(new std::atomic<Chunk*>[(max_connections + CHUNK_SIZE - 1) / CHUNK_SIZE]{}) {}
+
+template <Socket T>
+std::int32_t ConnectionPool<T>::add(const ConnectionPtr<T> connection) {
+  return store(allocate(), connection);
+}
+
+template <Socket T>
+std::int32_t ConnectionPool<T>::emplace(boost::asio::io_context& io_context, T&& socket,
+                                        RequestHandler<T> request_handler) {
+  auto id = allocate();
+  if (id < 0) {
+    return store(id, nullptr);
   }
+  return store(id, std::make_shared<Connection<T>>(io_context, std::move(socket),
+                                                   std::move(request_handler)));
 }
 
 template <Socket T>
-std::int32_t ConnectionPool<T>::add(const ConnectionPtr<T> connection) {
-  if (_available_ids.empty() && erase_unavaliable() == 0) {
+std::int32_t ConnectionPool<T>::store(std::int32_t id, ConnectionPtr<T> connection) {
+  if (id < 0) {
     utils::Logger::logger().warning("ConnectionPool Full");
     return -1;
   }
-
-  auto id = *_available_ids.begin();
-  _available_ids.erase(id);
-  _connections[id] = connection;
+  auto& slot_chunk = chunk(id);
+  auto pointer = connection.get();
+  // Published by the store below to whichever thread goes on to erase it.
+  slot_chunk.owners[id % CHUNK_SIZE] = std::move(connection);
+  slot_chunk.connections[id % CHUNK_SIZE].store(pointer, std::memory_order_release);
 #ifdef DEBUG
   utils::Logger::logger().debug("ConnectionPool add Connection: " + std::to_string(id));
 #endif
@@ -107,44 +180,215 @@ std::int32_t ConnectionPool<T>::add(const ConnectionPtr<T> connection) {
 }
 
 template <Socket T>
-std::int32_t ConnectionPool<T>::emplace(boost::asio::io_context& io_context, T socket,
-                                        utils::Queue<message::Data>& in_queue) {
-  if (_available_ids.empty() && erase_unavaliable() == 0) {
-    utils::Logger::logger().warning("ConnectionPool Full");
-    return -1;
+void ConnectionPool<T>::erase(std::int32_t id) {
+  auto slot = find_slot(id);
+  if (slot && slot->exchange(nullptr) != nullptr) {
+    retire(id);
   }
+}
 
-  auto id = *_available_ids.begin();
-  _available_ids.erase(id);
-  _connections[id] = std::make_shared<Connection<T>>(io_context, std::move(socket), in_queue);
-#ifdef DEBUG
-  utils::Logger::logger().debug("ConnectionPool add Connection: " + std::to_string(id));
-#endif
-  return id;
+template <Socket T>
+void ConnectionPool<T>::erase(ConnectionHandle handle) {
+  auto id = static_cast<std::int32_t>(handle & NIL);
+  auto slot = find_slot(id);
+  if (slot == nullptr) {
+    return;
+  }
+  // Pinned, the id cannot be reused, so a pointer equal to the one checked
+  // still belongs to the connection the handle names.
+  auto& pins = chunk(id).pins[id % CHUNK_SIZE];
+  pins.fetch_add(1);
+  auto connection = slot->load();
+  auto erased = connection != nullptr && is_valid(handle) &&
+                slot->compare_exchange_strong(connection, nullptr);
+  unpin(id);
+  if (erased) {
+    retire(id);
+  }
 }
 
 template <Socket T>
-void ConnectionPool<T>::erase_all() {
-  std::fill(_connections.begin(), _connections.end(), nullptr);
+ConnectionHandle ConnectionPool<T>::handle(std::int32_t id) const {
+  auto generation = find_generation(id);
+  if (generation == nullptr) {
+    return std::numeric_limits<ConnectionHandle>::max();
+  }
+  return static_cast<ConnectionHandle>(generation->load(std::memory_order_acquire)) << 32 |
+         static_cast<std::uint32_t>(id);
+}
+
+template <Socket T>
+bool ConnectionPool<T>::is_valid(ConnectionHandle handle) const {
+  auto generation = find_generation(static_cast<std::int32_t>(handle & NIL));
+  return generation != nullptr &&
+         generation->load(std::memory_order_acquire) == static_cast<std::uint32_t>(handle >> 32);
+}
+
+template <Socket T>
+ConnectionPtr<T> ConnectionPool<T>::get_connection(ConnectionHandle handle) {
+  auto id = static_cast<std::int32_t>(handle & NIL);
+  auto slot = find_slot(id);
+  if (slot == nullptr) {
+    return nullptr;
+  }
+  // Either retire() sees the pin and keeps the pool's reference until it is
+  // gone, or the load below sees the slot already cleared.
+  auto& pins = chunk(id).pins[id % CHUNK_SIZE];
+  pins.fetch_add(1);
+  ConnectionPtr<T> shared{};
+  auto connection = slot->load();
+  // A connection stored after the load was stored after its predecessor
+  // retired the generation, so the check sees the bump.
+  if (connection != nullptr && is_valid(handle)) {
+    shared = connection->get_shared_ptr();
+  }
+  unpin(id);
+  return shared;
+}
+
+template <Socket T>
+Connection<T>* ConnectionPool<T>::resolve(ConnectionHandle handle) const {
+  auto id = static_cast<std::int32_t>(handle & NIL);
+  if (find_slot(id) == nullptr || !is_valid(handle)) {
+    return nullptr;
+  }
+  auto connection = find_slot(id)->load(std::memory_order_acquire);
+  // A pointer stored after the first check belongs to a later connection,
+  // and the generation has moved on.
+  if (!is_valid(handle)) {
+    return nullptr;
+  }
+  return connection;
+}
+
+// Invalidates the handles of the erased connection, waits for lookups that
+// may still reach it, drops the pool's reference, then frees its id.
+template <Socket T>
+void ConnectionPool<T>::retire(std::uint32_t id) {
+  auto& slot_chunk = chunk(id);
+  slot_chunk.generations[id % CHUNK_SIZE].fetch_add(1, std::memory_order_release);
+  while (slot_chunk.pins[id % CHUNK_SIZE].load() != 0) {
+    std::this_thread::yield();
+  }
+  slot_chunk.owners[id % CHUNK_SIZE].reset();
+  release(id);
+}
+
+template <Socket T>
+void ConnectionPool<T>::unpin(std::uint32_t id) {
+  chunk(id).pins[id % CHUNK_SIZE].fetch_sub(1, std::memory_order_release);
+}
 
-  for (std::uint32_t i = 0; i < _max_connections; ++i) {
-    _available_ids.insert(i);
+template <Socket T>
+typename ConnectionPool<T>::Slot* ConnectionPool<T>::find_slot(std::int32_t id) const {
+  if (id < 0 || static_cast<std::uint32_t>(id) >= _max_connections) {
+    return nullptr;
+  }
+  auto chunk = _chunks[id / CHUNK_SIZE].load(std::memory_order_acquire);
+  return chunk ? &chunk->connections[id % CHUNK_SIZE] : nullptr;
+}
+
+template <Socket T>
+const std::atomic<std::uint32_t>* ConnectionPool<T>::find_generation(std::int32_t id) const {
+  if (id < 0 || static_cast<std::uint32_t>(id) >= _max_connections) {
+    return nullptr;
+  }
+  auto chunk = _chunks[id / CHUNK_SIZE].load(std::memory_order_acquire);
+  return chunk ? &chunk->generations[id % CHUNK_SIZE] : nullptr;
+}
+
+template <Socket T>
+typename ConnectionPool<T>::Chunk& ConnectionPool<T>::chunk(std::uint32_t id) {
+  auto& entry = _chunks[id / CHUNK_SIZE];
+  auto chunk = entry.load(std::memory_order_acquire);
+  if (chunk == nullptr) {
+    auto created = new Chunk();
+    if (entry.compare_exchange_strong(chunk, created, std::memory_order_acq_rel)) {
+      chunk = created;
+    } else {
+      // Another thread allocated the chunk first.
+      delete created;
+    }
   }
+  return *chunk;
+}
+
+template <Socket T>
+std::int32_t ConnectionPool<T>::allocate() {
+  auto head = _free_head.load(std::memory_order_acquire);
+  while (static_cast<std::uint32_t>(head) != NIL) {
+    auto id = static_cast<std::uint32_t>(head);
+    auto next = chunk(id).next[id % CHUNK_SIZE].load(std::memory_order_relaxed);
+    auto tagged = ((head >> 32) + 1) << 32 | next;
+    if (_free_head.compare_exchange_weak(head, tagged, std::memory_order_acq_rel)) {
+      _size.fetch_add(1, std::memory_order_relaxed);
+      return id;
+    }
+  }
+
+  auto id = _next_unused.load(std::memory_order_relaxed);
+  while (id < _max_connections) {
+    if (_next_unused.compare_exchange_weak(id, id + 1, std::memory_order_relaxed)) {
+      _size.fetch_add(1, std::memory_order_relaxed);
+      return id;
+    }
+  }
+
+  // Full. Closed connections give their slot back through their close
+  // handler, so there is nothing to reclaim here; the caller sheds the load.
+  return -1;
+}
+
+template <Socket T>
+void ConnectionPool<T>::release(std::uint32_t id) {
+  auto& next = chunk(id).next[id % CHUNK_SIZE];
+  auto head = _free_head.load(std::memory_order_relaxed);
+  std::uint64_t tagged;
+  do {
+    next.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+    tagged = ((head >> 32) + 1) << 32 | id;
+  } while (!_free_head.compare_exchange_weak(head, tagged, std::memory_order_release,
+                                             std::memory_order_relaxed));
+  _size.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template <Socket T>
+void ConnectionPool<T>::erase_all() {
+  auto used = _next_unused.load(std::memory_order_acquire);
+  for (std::uint32_t id = 0; id < used; ++id) {
+    if (auto slot = find_slot(id)) {
+      slot->store(nullptr, std::memory_order_relaxed);
+      chunk(id).owners[id % CHUNK_SIZE].reset();
+      chunk(id).generations[id % CHUNK_SIZE].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  _free_head.store(NIL, std::memory_order_relaxed);
+  _next_unused.store(0, std::memory_order_relaxed);
+  _size.store(0, std::memory_order_release);
 }
 
 template <Socket T>
 void ConnectionPool<T>::clear() {
-  _connections.clear();
-  _available_ids.clear();
+  erase_all();
+  auto chunk_count = (_max_connections + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  for (std::uint32_t i = 0; i < chunk_count; ++i) {
+    delete _chunks[i].exchange(nullptr, std::memory_order_acq_rel);
+  }
 }
 
 template <Socket T>
 std::size_t ConnectionPool<T>::erase_unavaliable() {
   std::size_t count = 0;
-  for (auto i = 0u; i < _max_connections; ++i) {
-    if (_connections[i] != nullptr && _connections[i]->closable()) {
-      _connections[i] = nullptr;
-      _available_ids.insert(i);
+  auto used = _next_unused.load(std::memory_order_acquire);
+  for (std::uint32_t id = 0; id < used; ++id) {
+    auto slot = find_slot(id);
+    if (slot == nullptr) {
+      continue;
+    }
+    auto connection = slot->load(std::memory_order_acquire);
+    if (connection != nullptr && connection->closable() &&
+        slot->compare_exchange_strong(connection, nullptr)) {
+      retire(id);
       ++count;
     }
   }
@@ -0,0 +1,48 @@
+/*
+ * Content codings
+ * Negotiation of Accept-Encoding (RFC 9110, section 12.5.3) and gzip
+ * compression with zlib. Static files may have precompressed siblings,
+ * foo.js.br and foo.js.gz, which are preferred to compressing on the fly.
+ */
+#ifndef CONTENT_CODING_H_
+#define CONTENT_CODING_H_
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace web_server {
+namespace message {
+
+// The codings a client accepts besides identity, which it always takes.
+struct AcceptedCodings {
+  bool br{false};
+  bool gzip{false};
+
+  // Codings with q=0 are refused; "*" stands for every coding not listed.
+  static AcceptedCodings parse(std::string_view accept_encoding);
+
+  bool any() const { return br || gzip; }
+  // "", "br", "gzip" or "br,gzip": one of CODING_VARIANTS.
+  std::string_view name() const;
+};
+
+// Every AcceptedCodings::name(); a file has one response per variant.
+inline constexpr std::array<std::string_view, 4> CODING_VARIANTS{"", "br", "gzip", "br,gzip"};
+
+// The extension of a file precompressed with coding, e.g. ".gz" for gzip.
+std::string_view coding_extension(std::string_view coding);
+
+// Smaller files are not compressed on the fly; the framing outweighs the gain.
+inline constexpr std::size_t MIN_COMPRESS_SIZE = 1024;
+
+// Compresses data into a gzip member, level 1 to 9. The input is fed to
+// zlib in bounded steps and the output grows as it is produced. Returns
+// false if zlib fails.
+bool gzip(std::string_view data, std::string& compressed, int level = 6);
+
+} // namespace message
+} // namespace web_server
+
+#endif // CONTENT_CODING_H_
@@ -25,9 +25,11 @@ public:
   const std::uint8_t* data() const { return _data; }
   const std::size_t& size() const { return _size; }
   const std::uint32_t& connection_id() const { return _connection_id; }
+  const std::uint64_t& sequence() const { return _sequence; }
   const std::size_t& capacity() const { return _capacity; }
 
   void set_connection_id(std::uint32_t connection_id) { _connection_id = connection_id; }
+  void set_sequence(std::uint64_t sequence) { _sequence = sequence; }
 
   void reserve(std::size_t capacity);
   void append(const std::uint8_t* data, std::size_t size);
@@ -39,10 +41,12 @@ public:
 private:
   std::allocator<std::uint8_t> _allocator;
 
-  std::uint8_t* _data;
-  std::size_t _size;
-  std::size_t _capacity;
-  std::uint32_t _connection_id;
+  std::uint8_t* _data{nullptr};
+  std::size_t _size{0};
+  std::size_t _capacity{0};
+  std::uint32_t _connection_id{0};
+  // Position of the request on its connection, used to order pipelined responses.
+  std::uint64_t _sequence{0};
 };
 
 } // namespace message
@@ -0,0 +1,169 @@
+/*
+ * FileCache class
+ * Keeps small, hot files in memory together with their serialized response
+ * header, so a cached file is answered without a single file system call.
+ *
+ * Entries are immutable and reference counted: a response holds its entry
+ * until it is sent, even if the entry is evicted or invalidated meanwhile.
+ * The cache is split into shards, each with its own lock, LRU list and
+ * share of the byte budget, so lookups from many workers rarely contend.
+ *
+ * A file has one entry per set of content codings clients accept, see
+ * CODING_VARIANTS, holding what is sent to them: the file itself, its
+ * precompressed sibling (path.br or path.gz) or the file compressed once
+ * when it was loaded.
+ *
+ * Instead of revalidating entries with stat(2), the cache watches every
+ * directory from a cached file up to the root with inotify(7) and drops
+ * entries as soon as the kernel reports a change. Only files untouched for
+ * a second are cached, and a load that races with a change is discarded,
+ * so a stale copy is never kept. Symbolic links are not cached: a change
+ * of their target would go unnoticed.
+ */
+#ifndef FILE_CACHE_H_
+#define FILE_CACHE_H_
+
+#include "content_coding.hpp"
+#include "file_region.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace web_server {
+namespace message {
+
+// A file held in memory. header and fields are filled in by the server when
+// the file is loaded.
+struct CachedFile {
+  // The file the entry was loaded from, e.g. index.html of a directory.
+  std::filesystem::path path;
+  FileMetadata metadata{};
+  // The full response header of the file, up to and including the empty line.
+  std::string header;
+  // Header lines, each ending in CRLF, sent with responses derived from the
+  // entry, such as 304.
+  std::string fields;
+  std::string entity_tag;
+  // The response depends on Accept-Encoding.
+  bool vary{false};
+  std::string body;
+};
+
+struct FileCacheOptions {
+  // Bytes of memory the entries may take; 0 disables the cache.
+  std::size_t capacity{64 * 1024 * 1024};
+  // Larger files are not cached and are sent with sendfile(2) instead.
+  std::size_t max_file_size{1024 * 1024};
+};
+
+// What the cache did since it was created; invalidations counts the
+// entries dropped because their file changed.
+struct FileCacheStats {
+  std::atomic<std::uint64_t> hits{0};
+  std::atomic<std::uint64_t> misses{0};
+  std::atomic<std::uint64_t> evictions{0};
+  std::atomic<std::uint64_t> invalidations{0};
+};
+
+class FileCache {
+public:
+  using Entry = std::shared_ptr<const CachedFile>;
+  using Prepare = std::function<void(CachedFile&)>;
+
+  FileCache() = delete;
+  // Only files below root, a canonical path, are cached.
+  explicit FileCache(std::filesystem::path root, FileCacheOptions options = {});
+  FileCache(const FileCache&) = delete;
+  FileCache(FileCache&&) = delete;
+  FileCache& operator=(const FileCache&) = delete;
+  FileCache& operator=(FileCache&&) = delete;
+  ~FileCache();
+
+  // Returns nullptr if nothing is cached under key for variant, one of
+  // CODING_VARIANTS.
+  Entry find(const std::filesystem::path& key, std::string_view variant = {});
+  // Reads the file at path, lets prepare fill in the header, and caches it
+  // under key and variant. key is the file, or the directory it is the
+  // index.html of, with or without a trailing slash; path is the file or,
+  // for a variant other than "", its precompressed sibling.
+  // Returns nullptr, and caches nothing, if the file is not a regular file
+  // below the root, too large, recently modified, reached through a
+  // symbolic link or a non-canonical path, or cannot be watched. An entry
+  // too large for the budget, or whose file changed while it was read, is
+  // returned but not kept.
+  Entry load(const std::filesystem::path& key, const std::filesystem::path& path,
+             const Prepare& prepare, std::string_view variant = {});
+
+  // Drops the entries cached under path and those loaded from it or its
+  // precompressed siblings. If path is a directory, every entry below it is
+  // dropped as well.
+  void invalidate(const std::filesystem::path& path, bool directory = false);
+  void clear();
+
+  bool enabled() const { return _watching.load(); }
+  // Bytes taken by the entries.
+  std::size_t size() const;
+  std::size_t count() const;
+  const FileCacheOptions& options() const { return _options; }
+  const FileCacheStats& stats() const { return _stats; }
+
+private:
+  static constexpr std::size_t SHARD_COUNT = 16;
+  // Accounted per entry on top of its path, header and body.
+  static constexpr std::size_t ENTRY_OVERHEAD = 256;
+
+  struct Shard {
+    using Lru = std::list<std::pair<std::string, Entry>>;
+
+    mutable std::mutex mutex{};
+    // Most recently used first.
+    Lru lru{};
+    std::unordered_map<std::string, Lru::iterator> index{};
+    std::size_t size{0};
+  };
+
+  // The name of an entry in its shard: the key, a NUL and the variant.
+  static std::string entry_name(const std::filesystem::path& key, std::string_view variant);
+  static std::size_t charge(const std::string& name, const CachedFile& file);
+  Shard& shard(const std::string& name);
+  // Drops every variant cached under key.
+  void drop(const std::filesystem::path& key);
+  // Removes the entry at it; the shard must be locked.
+  static void erase(Shard& shard, Shard::Lru::iterator it);
+  // Adds inotify watches on the directories from the parent of path up to
+  // the root.
+  bool watch(const std::filesystem::path& path);
+  void run_watcher();
+  void handle_events(const char* events, std::size_t size);
+
+  std::filesystem::path _root;
+  FileCacheOptions _options;
+  FileCacheStats _stats{};
+  std::array<Shard, SHARD_COUNT> _shards{};
+  // Bumped by every invalidation; a load is only stored if it is unchanged.
+  std::atomic<std::uint64_t> _generation{0};
+
+  // False if the cache is disabled or its watcher failed.
+  std::atomic<bool> _watching{false};
+  int _inotify_fd{-1};
+  // Wakes the watcher thread up to stop.
+  int _stop_fd{-1};
+  std::mutex _watch_mutex{};
+  std::unordered_map<int, std::filesystem::path> _watches{};
+  std::thread _watcher{};
+};
+
+} // namespace message
+} // namespace web_server
+
+#endif // FILE_CACHE_H_
@@ -0,0 +1,85 @@
+#ifndef FILE_REGION_H_
+#define FILE_REGION_H_
+
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <system_error>
+
+namespace web_server {
+namespace message {
+
+// What stat(2) tells about a file: enough to answer a request about it
+// without opening it.
+struct FileMetadata {
+  bool is_regular{false};
+  bool is_directory{false};
+  std::uint64_t size{0};
+  // Time of the last modification, in seconds and the nanoseconds within.
+  std::time_t modified{0};
+  std::uint32_t modified_nsec{0};
+  std::uint64_t inode{0};
+
+  // Returns nullopt if the file does not exist or cannot be accessed.
+  static std::optional<FileMetadata> stat(const std::filesystem::path& path);
+};
+
+// An open, read-only file descriptor. The descriptor is closed when the last
+// owner goes away, so a response can keep the file open until it is sent.
+class File {
+public:
+  File() = delete;
+  File(int fd);
+  File(const File&) = delete;
+  File(File&&) = delete;
+  File& operator=(const File&) = delete;
+  File& operator=(File&&) = delete;
+  ~File();
+
+  // Returns nullptr if the file cannot be opened.
+  static std::shared_ptr<File> open(const std::filesystem::path& path);
+
+  int fd() const { return _fd; }
+  // Taken when the file was opened.
+  const FileMetadata& metadata() const { return _metadata; }
+  bool is_regular() const { return _metadata.is_regular; }
+  std::uint64_t size() const { return _metadata.size; }
+  std::time_t modified() const { return _metadata.modified; }
+
+private:
+  int _fd;
+  FileMetadata _metadata{};
+};
+
+// A byte range of a file that is transmitted without copying it into a
+// user space buffer first.
+class FileRegion {
+public:
+  FileRegion() = delete;
+  FileRegion(std::shared_ptr<const File> file, std::uint64_t offset, std::uint64_t length)
+      : _file(std::move(file)), _offset(offset), _length(length) {}
+
+  const File& file() const { return *_file; }
+  std::uint64_t offset() const { return _offset; }
+  std::uint64_t length() const { return _length; }
+
+  // Sends the region, starting `sent` bytes into it, to a socket with
+  // sendfile(2). Returns the number of bytes sent by this call.
+  std::size_t send_to(int socket_fd, std::uint64_t sent, std::error_code& ec) const;
+  // Reads the region, starting `sent` bytes into it, into buffer.
+  // Used for files sendfile(2) cannot handle.
+  std::size_t read(std::uint64_t sent, std::uint8_t* buffer, std::size_t size,
+                   std::error_code& ec) const;
+
+private:
+  std::shared_ptr<const File> _file;
+  std::uint64_t _offset;
+  std::uint64_t _length;
+};
+
+} // namespace message
+} // namespace web_server
+
+#endif // FILE_REGION_H_
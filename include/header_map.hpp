@@ -0,0 +1,148 @@
+/*
+ * HeaderMap class
+ * The header fields of a message. Field names are case-insensitive
+ * (RFC 9110, section 5.1). Well-known names are interned to a HeaderId
+ * through a table built at compile time, so looking one up indexes an
+ * array instead of hashing a string; other names are matched by scanning
+ * the few fields a message has. Fields are kept in a flat vector, inline
+ * for typical messages, in the order they were added.
+ *
+ * The server builds response headers in a HeaderMap, which owns its
+ * strings. Received headers go in a HeaderViewMap, whose names and values
+ * are views into the request bytes, so filling one does not allocate
+ * unless a name repeats; the bytes must outlive the map.
+ */
+#ifndef HEADER_MAP_H_
+#define HEADER_MAP_H_
+
+#include <array>
+#include <boost/container/small_vector.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace web_server {
+namespace message {
+
+enum class HeaderId : std::uint8_t {
+  accept,
+  accept_encoding,
+  accept_language,
+  accept_ranges,
+  age,
+  allow,
+  authorization,
+  cache_control,
+  connection,
+  content_disposition,
+  content_encoding,
+  content_language,
+  content_length,
+  content_location,
+  content_range,
+  content_type,
+  cookie,
+  date,
+  etag,
+  expect,
+  expires,
+  host,
+  if_match,
+  if_modified_since,
+  if_none_match,
+  if_range,
+  if_unmodified_since,
+  keep_alive,
+  last_modified,
+  location,
+  origin,
+  pragma,
+  range,
+  referer,
+  retry_after,
+  server,
+  set_cookie,
+  te,
+  trailer,
+  transfer_encoding,
+  upgrade,
+  user_agent,
+  vary,
+  via,
+  www_authenticate,
+  // Any other name.
+  other
+};
+
+inline constexpr std::size_t HEADER_ID_COUNT = static_cast<std::size_t>(HeaderId::other);
+
+// The id of a field name, compared case-insensitively, or HeaderId::other.
+HeaderId header_id(std::string_view name);
+// The canonical spelling of a well-known name, e.g. "Content-Length".
+std::string_view header_name(HeaderId id);
+
+// Value is std::string or std::string_view.
+template <typename Value>
+class BasicHeaderMap {
+public:
+  struct Field {
+    HeaderId id{HeaderId::other};
+    // Only kept for names that are not well known.
+    Value other_name{};
+    Value value{};
+
+    std::string_view name() const { return id == HeaderId::other ? other_name : header_name(id); }
+  };
+  using Fields = boost::container::small_vector<Field, 16>;
+
+  // Adds a field line as received. A repeated name is combined into the
+  // first field as a comma-separated list (RFC 9110, section 5.3), except
+  // Set-Cookie, whose lines cannot be combined.
+  void add(std::string_view name, std::string_view value);
+  // Replaces the value of the field named name, or adds it.
+  void set(std::string_view name, std::string_view value);
+  void set(HeaderId id, std::string_view value);
+  // Removes every field named name. Returns false if there was none.
+  bool erase(std::string_view name);
+  void clear();
+
+  bool contains(HeaderId id) const { return _index[static_cast<std::size_t>(id)] != 0; }
+  bool contains(std::string_view name) const { return find(name) != nullptr; }
+  // The value of the first field named name, or nullptr.
+  const Value* find(HeaderId id) const;
+  const Value* find(std::string_view name) const;
+  // Throws std::out_of_range if there is no field named name.
+  const Value& at(HeaderId id) const;
+  const Value& at(std::string_view name) const;
+
+  std::size_t size() const { return _fields.size(); }
+  bool empty() const { return _fields.empty(); }
+  Fields::const_iterator begin() const { return _fields.begin(); }
+  Fields::const_iterator end() const { return _fields.end(); }
+
+private:
+  Field* find_field(HeaderId id, std::string_view name);
+  const Field* find_field(HeaderId id, std::string_view name) const;
+  void append(HeaderId id, std::string_view name, std::string_view value);
+
+  Fields _fields{};
+  // One more than the position in _fields of the first field with each
+  // well-known id, or 0.
+  std::array<std::uint16_t, HEADER_ID_COUNT> _index{};
+  // What the values of repeated fields of a view map were combined into,
+  // shared so that the views of a copy stay valid.
+  std::vector<std::shared_ptr<const std::string>> _combined{};
+};
+
+using HeaderMap = BasicHeaderMap<std::string>;
+using HeaderViewMap = BasicHeaderMap<std::string_view>;
+
+extern template class BasicHeaderMap<std::string>;
+extern template class BasicHeaderMap<std::string_view>;
+
+} // namespace message
+} // namespace web_server
+
+#endif // HEADER_MAP_H_
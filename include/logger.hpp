@@ -1,8 +1,10 @@
 #ifndef LOGGER_H_
 #define LOGGER_H_
 
+#include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 
 namespace web_server {
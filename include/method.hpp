@@ -0,0 +1,80 @@
+/*
+ * Request methods
+ * The methods the server knows (RFC 9110, section 9) and their names. A
+ * method token is recognized by packing its bytes into an integer and
+ * comparing that against constants computed at compile time, instead of
+ * comparing strings one after another.
+ */
+#ifndef METHOD_H_
+#define METHOD_H_
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+namespace web_server {
+namespace message {
+
+enum class Method { GET, POST, PUT, DELETE, HEAD, OPTIONS, TRACE, CONNECT, PATCH };
+
+inline constexpr std::array<std::string_view, 9> METHOD_NAMES{
+    "GET", "POST", "PUT", "DELETE", "HEAD", "OPTIONS", "TRACE", "CONNECT", "PATCH"};
+
+constexpr std::string_view method_name(Method method) {
+  return METHOD_NAMES[static_cast<std::size_t>(method)];
+}
+
+// The bytes of a token of up to 7 bytes as they lie in memory, read as a
+// native integer, with the size of the token in the last byte so that
+// trailing NUL bytes are not mistaken for padding.
+constexpr std::uint64_t pack_size(std::size_t size) {
+  return static_cast<std::uint64_t>(size) << (std::endian::native == std::endian::little ? 56 : 0);
+}
+
+constexpr std::uint64_t pack_method(std::string_view token) {
+  std::uint64_t packed = pack_size(token.size());
+  for (std::size_t i = 0; i < token.size() && i < 7; ++i) {
+    auto shift = std::endian::native == std::endian::little ? 8 * i : 8 * (7 - i);
+    packed |= static_cast<std::uint64_t>(static_cast<unsigned char>(token[i])) << shift;
+  }
+  return packed;
+}
+
+// The method named token, which is case-sensitive, or nullopt.
+inline std::optional<Method> parse_method(std::string_view token) {
+  if (token.empty() || token.size() > 7) {
+    return std::nullopt;
+  }
+  std::uint64_t packed = 0;
+  std::memcpy(&packed, token.data(), token.size());
+  switch (packed | pack_size(token.size())) {
+  case pack_method("GET"):
+    return Method::GET;
+  case pack_method("HEAD"):
+    return Method::HEAD;
+  case pack_method("POST"):
+    return Method::POST;
+  case pack_method("PUT"):
+    return Method::PUT;
+  case pack_method("DELETE"):
+    return Method::DELETE;
+  case pack_method("OPTIONS"):
+    return Method::OPTIONS;
+  case pack_method("TRACE"):
+    return Method::TRACE;
+  case pack_method("CONNECT"):
+    return Method::CONNECT;
+  case pack_method("PATCH"):
+    return Method::PATCH;
+  default:
+    return std::nullopt;
+  }
+}
+
+} // namespace message
+} // namespace web_server
+
+#endif // METHOD_H_
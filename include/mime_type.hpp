@@ -0,0 +1,27 @@
+/*
+ * MIME types
+ * Maps file names to the media type sent in Content-Type, and tells which
+ * media types are worth compressing.
+ */
+#ifndef MIME_TYPE_H_
+#define MIME_TYPE_H_
+
+#include <filesystem>
+#include <string_view>
+
+namespace web_server {
+namespace message {
+
+// Sent for files of unknown type.
+inline constexpr std::string_view DEFAULT_MIME_TYPE = "application/octet-stream";
+
+// The media type of a file by its extension, ignoring case.
+std::string_view mime_type(const std::filesystem::path& path);
+// Text-like types shrink when compressed; images, media and archives are
+// compressed already.
+bool is_compressible(std::string_view mime_type);
+
+} // namespace message
+} // namespace web_server
+
+#endif // MIME_TYPE_H_
@@ -0,0 +1,60 @@
+#ifndef PAYLOAD_H_
+#define PAYLOAD_H_
+
+#include "buffer.hpp"
+#include "data.hpp"
+#include "file_region.hpp"
+
+#include <variant>
+#include <vector>
+
+namespace web_server {
+namespace message {
+
+// What a handler sends back: a list of segments written to the socket in
+// order. Consecutive memory segments go out in one gathered write, file
+// regions are transmitted with sendfile(2). Nothing is concatenated.
+class Payload {
+public:
+  using Segment = std::variant<Buffer, FileRegion>;
+
+  Payload() = default;
+  explicit Payload(std::uint32_t connection_id): _connection_id(connection_id) {}
+  Payload(Data data): _connection_id(data.connection_id()), _sequence(data.sequence()) {
+    append(Buffer::own(std::move(data)));
+  }
+
+  const std::vector<Segment>& segments() const { return _segments; }
+
+  const std::uint32_t& connection_id() const { return _connection_id; }
+  const std::uint64_t& sequence() const { return _sequence; }
+  std::uint64_t size() const { return _size; }
+
+  void set_connection_id(std::uint32_t connection_id) { _connection_id = connection_id; }
+  void set_sequence(std::uint64_t sequence) { _sequence = sequence; }
+
+  void append(Buffer buffer) {
+    if (buffer.size() > 0) {
+      _size += buffer.size();
+      _segments.emplace_back(std::move(buffer));
+    }
+  }
+
+  void append(FileRegion region) {
+    if (region.length() > 0) {
+      _size += region.length();
+      _segments.emplace_back(std::move(region));
+    }
+  }
+
+private:
+  std::vector<Segment> _segments;
+  std::uint32_t _connection_id{0};
+  std::uint64_t _sequence{0};
+  std::uint64_t _size{0};
+};
+
+} // namespace message
+} // namespace web_server
+
+#endif // PAYLOAD_H_
@@ -0,0 +1,71 @@
+/*
+ * Reactor class
+ * A reactor is one event loop: an io_context driven by its own thread,
+ * plus an acceptor listening on the server port. Every connection accepted
+ * by a reactor lives on that reactor's io_context, so its reads, writes and
+ * completion handlers never leave the reactor thread.
+ *
+ * Several reactors can listen on the same port because the acceptors are
+ * bound with SO_REUSEPORT, which lets the kernel spread incoming
+ * connections across them.
+ *
+ * Every reactor is a listener of its own and carries its own
+ * SocketOptions, applied to the acceptor when it starts listening and to
+ * every socket it accepts.
+ */
+#ifndef REACTOR_H_
+#define REACTOR_H_
+
+#include "socket_options.hpp"
+
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <optional>
+#include <thread>
+
+namespace web_server {
+namespace reactor {
+
+using ReusePort = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+class Reactor {
+public:
+  Reactor() = delete;
+  Reactor(std::uint32_t index, const boost::asio::ip::tcp::endpoint& endpoint);
+  Reactor(const Reactor&) = delete;
+  Reactor(Reactor&&) = delete;
+  Reactor& operator=(const Reactor&) = delete;
+  Reactor& operator=(Reactor&&) = delete;
+  ~Reactor() { stop(); }
+
+  std::uint32_t index() const { return _index; }
+  boost::asio::io_context& io_context() { return _io_context; }
+  boost::asio::ip::tcp::acceptor& acceptor() { return _acceptor; }
+  const SocketOptions& socket_options() const { return _socket_options; }
+
+  // Applies the socket options and starts listening; the acceptor is bound
+  // by the constructor.
+  void listen(int backlog = boost::asio::socket_base::max_listen_connections,
+              const SocketOptions& socket_options = SocketOptions());
+
+  // Starts the event loop thread, optionally pinned to the given cpu.
+  void run(std::optional<std::uint32_t> cpu = std::nullopt);
+  void stop();
+
+private:
+  static void pin_to_cpu(std::uint32_t cpu);
+
+  std::uint32_t _index;
+
+  boost::asio::io_context _io_context;
+  boost::asio::executor_work_guard<boost::asio::io_context::executor_type> _work_guard;
+  boost::asio::ip::tcp::acceptor _acceptor;
+  SocketOptions _socket_options;
+
+  std::thread _thread;
+};
+
+} // namespace reactor
+} // namespace web_server
+
+#endif // REACTOR_H_
@@ -1,37 +1,57 @@
 #ifndef REQUEST_H_
 #define REQUEST_H_
 
+#include "buffer.hpp"
 #include "request_header.hpp"
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace web_server {
 namespace message {
 
+// The body is not copied out of the received bytes. It is either a view
+// into them, valid while they are, or a slice sharing their ownership.
+// A handler that keeps the body past the bytes it was parsed from takes it
+// with retain_body().
 class Request: public std::enable_shared_from_this<Request> {
 public:
   Request() = default;
-  Request(const RequestHeader& header, const std::string& body)
-      : _body(std::move(body)), _header(std::move(header)) {}
+  Request(const RequestHeader& header, std::string body)
+      : _body(Buffer::own(std::move(body))), _header(header) {}
+  // The body views data, which must outlive the request.
   Request(const DataView& data);
+  // The body is a slice of data, which the request takes over.
+  Request(Data&& data);
+  // The same, with the header parser completed on the leading bytes of
+  // data, so they are not parsed again.
+  Request(Data&& data, const RequestParser& parser);
 
   ~Request() = default;
 
-  const std::string& body() const { return _body; }
+  std::string_view body() const { return _body.to_string_view(); }
   const RequestHeader& header() const { return _header; }
-
-  void set_body(const std::string& body) { _body = body; }
+  std::uint32_t connection_id() const { return _connection_id; }
+  // Position of the request on its connection.
+  std::uint64_t sequence() const { return _sequence; }
+  // The body as a buffer that keeps its memory alive: shared when the
+  // request owns its bytes, copied once when it only views them.
+  Buffer retain_body() const;
+
+  void set_body(std::string body) { _body = Buffer::own(std::move(body)); }
   void set_header(const RequestHeader& header) { _header = header; }
 
   void to_bytes(std::string& data) const {
     _header.to_bytes(data);
-    data += _body;
+    data += body();
   }
 
 private:
-  std::string _body;
+  Buffer _body{Buffer::view({})};
   RequestHeader _header;
+  std::uint32_t _connection_id{0};
+  std::uint64_t _sequence{0};
 };
 
 } // namespace message
@@ -3,6 +3,8 @@
 
 #include "data_buffer.hpp"
 #include "data_view.hpp"
+#include "header_map.hpp"
+#include "method.hpp"
 #include "utils.hpp"
 
 #include <memory>
@@ -11,44 +13,55 @@
 namespace web_server {
 namespace message {
 
-enum class Method { GET, POST, PUT, DELETE, HEAD, OPTIONS, TRACE, CONNECT, PATCH };
+class RequestParser;
 
+// The request line and field values are views into the bytes the header
+// was parsed from, which must outlive it.
 class RequestHeader: public std::enable_shared_from_this<RequestHeader> {
 public:
   RequestHeader() = default;
+  // The header parser completed, with its views moved into bytes: a copy of
+  // the data parser last parsed.
+  RequestHeader(const RequestParser& parser, std::string_view bytes);
   ~RequestHeader() = default;
 
+  // Returns the size of the header, up to and including the empty line, or
+  // 0 if data does not start with a complete, well-formed header.
   int parse(const DataView& data);
   std::size_t to_bytes(std::string& bytes) const;
 
-  const std::string& path() const { return _path; }
+  std::string_view path() const { return _path; }
 
-  void set_path(const std::string& path) { _path = path; }
+  void set_path(std::string_view path) { _path = path; }
 
-  const std::string& version() const { return _version; }
+  std::string_view version() const { return _version; }
 
-  void set_version(const std::string& version) { _version = version; }
+  void set_version(std::string_view version) { _version = version; }
 
   const Method& method() const { return _method; }
 
   void set_method(const Method& method) { _method = method; }
 
-  bool contain(const std::string& key) const { return _headers.find(key) != _headers.end(); }
+  // Field names are case-insensitive; get() throws std::out_of_range if the
+  // field is missing.
+  bool contain(std::string_view key) const { return _headers.contains(key); }
+  bool contain(HeaderId id) const { return _headers.contains(id); }
 
-  const std::string& get(const std::string& key) const { return _headers.at(key); }
+  std::string_view get(std::string_view key) const { return _headers.at(key); }
+  std::string_view get(HeaderId id) const { return _headers.at(id); }
 
-  void set(const std::string& key, const std::string& value) { _headers[key] = value; }
+  // Keeps a view of value, which must outlive the header.
+  void set(std::string_view key, std::string_view value) { _headers.set(key, value); }
+  void set(HeaderId id, std::string_view value) { _headers.set(id, value); }
 
-private:
-  void parse_method(std::string_view method);
-
-  [[nodiscard]] std::string method_to_string() const;
+  const HeaderViewMap& headers() const { return _headers; }
 
-  std::string _path;
-  std::string _version;
-  Method _method;
+private:
+  std::string_view _path;
+  std::string_view _version;
+  Method _method{Method::GET};
 
-  std::unordered_map<std::string, std::string> _headers;
+  HeaderViewMap _headers;
 };
 
 } // namespace message
@@ -0,0 +1,146 @@
+/*
+ * RequestParser class
+ * Parses the request line and header fields of an HTTP/1.1 request
+ * (RFC 9112, sections 2 to 5) with a resumable state machine. parse() is
+ * called with the bytes of the request received so far and picks up where
+ * the previous call stopped, so every byte is examined once however the
+ * header is split across reads; the buffer may move between calls.
+ *
+ * Tokens are kept as offsets into the request and handed out as views, so
+ * parsing never allocates. Runs of bytes within a token are skipped with
+ * the vectorized kernels of char_scan.hpp. Malformed requests end in an
+ * Error naming the status code to answer with, instead of an exception.
+ */
+#ifndef REQUEST_PARSER_H_
+#define REQUEST_PARSER_H_
+
+#include "method.hpp"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+namespace web_server {
+namespace message {
+
+class RequestParser {
+public:
+  enum class Status { incomplete, complete, error };
+  enum class Error {
+    none,
+    // 400: not HTTP/1.x syntax.
+    bad_request,
+    // 414: the request line is over its limit.
+    uri_too_long,
+    // 431: the header is over its limit or has too many fields.
+    header_fields_too_large,
+    // 501: a well-formed method the server does not know.
+    not_implemented,
+    // 505: an HTTP version other than 1.x.
+    version_not_supported
+  };
+
+  struct Field {
+    std::string_view name;
+    // Without leading and trailing whitespace.
+    std::string_view value;
+  };
+
+  // Fields beyond this count make the header too large.
+  static constexpr std::size_t MAX_FIELDS = 100;
+
+  explicit RequestParser(std::size_t max_request_line = std::numeric_limits<std::size_t>::max(),
+                         std::size_t max_header_size = std::numeric_limits<std::size_t>::max())
+      : _max_request_line(max_request_line), _max_header_size(max_header_size) {}
+
+  void set_limits(std::size_t max_request_line, std::size_t max_header_size) {
+    _max_request_line = max_request_line;
+    _max_header_size = max_header_size;
+  }
+  // Starts over with the next request.
+  void reset();
+
+  // data holds the request from its first byte: what an earlier call saw,
+  // possibly moved, followed by what arrived since. Once complete or
+  // failed, further calls return the same status.
+  Status parse(std::string_view data);
+
+  Status status() const { return _status; }
+  Error error() const { return _error; }
+  // The status code of error(), or 0.
+  int error_status_code() const;
+
+  // The accessors below are valid once the request is complete; the views
+  // point into the data last passed to parse().
+  // Bytes of the request line and fields, including the empty line.
+  std::size_t header_size() const { return _position; }
+  // The data last passed to parse(), which the views point into.
+  std::string_view data() const { return _data; }
+  Method method() const { return _method; }
+  std::string_view target() const { return view(_target); }
+  std::string_view version() const { return view(_version); }
+  std::size_t field_count() const { return _field_count; }
+  Field field(std::size_t index) const {
+    return {view(_fields[index].name), view(_fields[index].value)};
+  }
+  // The value of the first field named name, compared case-insensitively.
+  std::optional<std::string_view> find(std::string_view name) const;
+
+private:
+  enum class State {
+    method,
+    target,
+    version,
+    request_line_lf,
+    field_start,
+    field_name,
+    field_value_start,
+    field_value,
+    field_lf,
+    header_end_lf,
+    done
+  };
+
+  // Offset and size in the request; 32 bits are plenty under the limits.
+  struct Token {
+    std::uint32_t offset{0};
+    std::uint32_t size{0};
+  };
+  struct FieldTokens {
+    Token name;
+    Token value;
+  };
+
+  std::string_view view(Token token) const { return _data.substr(token.offset, token.size); }
+  Status fail(Error error);
+  // Validates the request line once its CRLF is found.
+  Status finish_request_line();
+
+  std::size_t _max_request_line;
+  std::size_t _max_header_size;
+
+  std::string_view _data{};
+  State _state{State::method};
+  Status _status{Status::incomplete};
+  Error _error{Error::none};
+  // The next byte to examine.
+  std::size_t _position{0};
+  // Where the request line starts, after empty lines preceding it.
+  std::size_t _line_start{0};
+  // Where the token being read starts.
+  std::size_t _token_start{0};
+
+  Method _method{Method::GET};
+  Token _method_token{};
+  Token _target{};
+  Token _version{};
+  std::array<FieldTokens, MAX_FIELDS> _fields{};
+  std::size_t _field_count{0};
+};
+
+} // namespace message
+} // namespace web_server
+
+#endif // REQUEST_PARSER_H_
@@ -1,36 +1,55 @@
 #ifndef RESPONSE_H_
 #define RESPONSE_H_
 
+#include "payload.hpp"
 #include "response_header.hpp"
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace web_server {
 namespace message {
 
+// The body is held like the body of a Request: a view into the bytes it
+// was parsed from, or a slice sharing their ownership.
 class Response: public std::enable_shared_from_this<Response> {
 public:
   Response() = default;
-  Response(const ResponseHeader& header, const std::string& body)
-      : _body(std::move(body)), _header(std::move(header)) {}
+  Response(const ResponseHeader& header, std::string body)
+      : _body(Buffer::own(std::move(body))), _header(header) {}
+  // The body views data, which must outlive the response.
   Response(const DataView& data);
+  // The body is a slice of data, which the response takes over.
+  Response(Data&& data);
 
   ~Response() = default;
 
-  const std::string& body() const { return _body; }
+  std::string_view body() const { return _body.to_string_view(); }
   const ResponseHeader& header() const { return _header; }
+  // The body as a buffer that keeps its memory alive: shared when the
+  // response owns its bytes, copied once when it only views them.
+  Buffer retain_body() const;
 
-  void set_body(const std::string& body) { _body = body; }
+  void set_body(std::string body) { _body = Buffer::own(std::move(body)); }
   void set_header(const ResponseHeader& header) { _header = header; }
 
   void to_bytes(std::string& data) const {
     _header.to_bytes(data);
-    data += _body;
+    data += body();
+  }
+
+  // Appends the serialized header and the body without copying the body,
+  // which stays shared with this response, unless the response only views it.
+  void to_payload(Payload& payload) const {
+    std::string header{};
+    _header.to_bytes(header);
+    payload.append(Buffer::own(std::move(header)));
+    payload.append(retain_body());
   }
 
 private:
-  std::string _body;
+  Buffer _body{Buffer::view({})};
   ResponseHeader _header;
 };
 
@@ -2,6 +2,8 @@
 #define RESPONSE_HEADER_H_
 
 #include "data_view.hpp"
+#include "header_map.hpp"
+#include "status_code.hpp"
 #include "utils.hpp"
 
 #include <memory>
@@ -12,12 +14,21 @@ namespace message {
 class ResponseHeader: public std::enable_shared_from_this<ResponseHeader> {
 public:
   ResponseHeader() = default;
-  ResponseHeader(std::uint32_t status_code, const std::string& status_message)
+  // With the registered reason phrase of status_code.
+  explicit ResponseHeader(std::uint32_t status_code)
+      : _status_code(status_code), _status_message(reason_phrase(status_code)) {}
+  ResponseHeader(std::uint32_t status_code, std::string status_message)
       : _status_code(status_code), _status_message(std::move(status_message)) {}
 
   ~ResponseHeader() = default;
 
   int parse(const DataView& data);
+  // The bytes of the serialized header, up to and including the empty line.
+  std::size_t size() const;
+  // Serializes the header into buffer, which holds at least size() bytes,
+  // without allocating. Returns the bytes written.
+  std::size_t write(char* buffer) const;
+  // Appends the serialized header to bytes and returns the size of bytes.
   std::size_t to_bytes(std::string& bytes) const;
 
   const std::string& version() const { return _version; }
@@ -28,16 +39,26 @@ public:
   void set_status_code(std::uint32_t status_code) { _status_code = status_code; }
   void set_status_message(const std::string& status_message) { _status_message = status_message; }
 
-  bool contain(const std::string& key) const { return _headers.contains(key); }
-  const std::string& get(const std::string& key) const { return _headers.at(key); }
-  void set(const std::string& key, const std::string& value) { _headers[key] = value; }
+  // Field names are case-insensitive; get() throws std::out_of_range if the
+  // field is missing.
+  bool contain(std::string_view key) const { return _headers.contains(key); }
+  bool contain(HeaderId id) const { return _headers.contains(id); }
+  const std::string& get(std::string_view key) const { return _headers.at(key); }
+  const std::string& get(HeaderId id) const { return _headers.at(id); }
+  void set(std::string_view key, std::string_view value) { _headers.set(key, value); }
+  void set(HeaderId id, std::string_view value) { _headers.set(id, value); }
+  const HeaderMap& headers() const { return _headers; }
 
 private:
-  std::string _version;
-  std::uint32_t _status_code;
-  std::string _status_message;
+  // The prebuilt status line, if the header has the registered reason
+  // phrase for HTTP/1.1, or an empty view.
+  std::string_view prebuilt_status_line() const;
 
-  std::unordered_map<std::string, std::string> _headers;
+  std::string _version{"HTTP/1.1"};
+  std::uint32_t _status_code{200};
+  std::string _status_message{"OK"};
+
+  HeaderMap _headers;
 };
 
 } // namespace message
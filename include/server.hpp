@@ -5,38 +5,112 @@
  * dispatching requests to the corresponding handlers.
  * It also manages the connection pool and thread pool.
  *
- * But we can only have one server running at a time,
- * since only one _acceptor can be created for each port.
- * Therefore, TODO: we need to support multiple servers
+ * Connections are accepted by a set of reactors, one event loop per
+ * thread (by default one per hardware thread). Each reactor owns an
+ * acceptor bound with SO_REUSEPORT, so the kernel balances incoming
+ * connections across them, and every accepted connection stays on the
+ * reactor that accepted it.
+ *
+ * Dispatch is completion driven: when a connection has read a request it
+ * hands it to the server, which runs the handler on a worker thread (or
+ * inline on the reactor if T declares `static constexpr bool inline_handler
+ * = true`) and posts the response back to the connection's reactor. Worker
+ * tasks only hold the connection's pool handle: a response to a connection
+ * that was closed meanwhile is dropped, even if its slot was reused.
+ * Pipelined requests on one connection are handled concurrently; the
+ * connection writes their responses back in request order.
+ *
+ * A request body with a Content-Length up to Limits::max_buffered_body
+ * comes with its request. Larger and chunked bodies are streamed to
+ * T::implement_handle_body(connection_id, chunk, last) on the reactor
+ * thread, in order, if T declares it, and are discarded otherwise.
+ *
+ * Socket options (TCP_NODELAY by default) are set on every listener and
+ * accepted socket, see reactor::SocketOptions, and logged at startup.
+ *
+ * Idle, header, body and write timeouts of every connection run on the
+ * timing wheel of its reactor, see connection::Timeouts. Request headers
+ * are capped by connection::Limits, so a slow or hostile client can hold
+ * neither a pool slot nor memory for long.
+ *
+ * Under overload the server sheds work instead of queueing it without
+ * bound, see Admission: requests beyond the worker backlog are answered
+ * 503 from a static buffer, reactors stop accepting while the connection
+ * limit is reached, and connections stop reading while too many of their
+ * pipelined requests are outstanding.
  */
 #ifndef SERVER_H_
 #define SERVER_H_
 
+#include "assets.hpp"
 #include "connection_pool.hpp"
 #include "data.hpp"
 #include "logger.hpp"
-#include "queue.hpp"
+#include "payload.hpp"
+#include "reactor.hpp"
+#include "request.hpp"
+#include "socket_options.hpp"
 #include "thread_pool.hpp"
+#include "timer_service.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <boost/asio.hpp>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace web_server {
 
 using TcpSocket = boost::asio::ip::tcp::socket;
 using TcpConnectionPool = connection::ConnectionPool<TcpSocket>;
 using TcpConnectionPtr = connection::ConnectionPtr<TcpSocket>;
+using connection::ConnectionHandle;
+using reactor::SocketOptions;
+
+// Limits past which the server sheds load, all with hysteresis: a limit
+// reached at the high watermark is lifted at the low one.
+struct Admission {
+  // Requests waiting for a worker thread; the excess is answered 503.
+  std::size_t task_high_watermark{4096};
+  std::size_t task_low_watermark{3072};
+  // Open connections, capped by the pool size; reactors stop accepting and
+  // leave new connections in the kernel backlog.
+  std::uint32_t connection_high_watermark{std::numeric_limits<std::uint32_t>::max()};
+  std::uint32_t connection_low_watermark{std::numeric_limits<std::uint32_t>::max()};
+  // Requests of one connection waiting for their response to be written.
+  std::uint32_t pipeline_high_watermark{64};
+  std::uint32_t pipeline_low_watermark{32};
+};
+
+// How the reactors accept connections. Must be set before start().
+struct AcceptOptions {
+  // async_accept operations kept outstanding on every acceptor.
+  std::uint32_t pending_accepts{4};
+  // Connections taken from the backlog per wakeup before other work runs.
+  std::uint32_t batch_size{64};
+  // Listen backlog of every acceptor.
+  int backlog{boost::asio::socket_base::max_listen_connections};
+};
+
+// Counters of the work the server turned away.
+struct LoadStats {
+  // Requests answered 503 because the worker backlog was full.
+  std::atomic<std::uint64_t> shed_requests{0};
+  // Accepted connections answered 503 because the pool was full.
+  std::atomic<std::uint64_t> rejected_connections{0};
+  // Times a reactor stopped accepting at the connection high watermark.
+  std::atomic<std::uint64_t> accept_pauses{0};
+};
 
 template <typename T>
 class Server {
 public:
   Server() = delete;
-  Server(std::uint16_t port)
-      : _io_context(), _port(port),
-        _acceptor(_io_context, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)),
-        _in_queue(), _out_queue(), _receive_thread_pool(4), _send_thread_pool(4),
-        _listen_thread_pool(4), _connection_pool(20) {}
+  // reactor_count == 0 creates one reactor per hardware thread.
+  // pin_reactors binds reactor i to cpu i (modulo the number of cpus).
+  Server(std::uint16_t port, std::uint32_t reactor_count = 0, bool pin_reactors = false);
   Server(const Server&) = delete;
   Server(Server&&) = delete;
   Server& operator=(const Server&) = delete;
@@ -48,79 +122,160 @@ public:
 
   TcpConnectionPool& get_connection_pool() { return _connection_pool; }
 
+  // Applies to connections accepted afterwards.
+  void set_timeouts(const connection::Timeouts& timeouts) { _timeouts = timeouts; }
+  void set_limits(const connection::Limits& limits) { _limits = limits; }
+  // Must be called before start().
+  void set_admission(const Admission& admission);
+  void set_accept_options(const AcceptOptions& accept_options);
+  // Must be called before start(). The overload taking a reactor index
+  // configures a single listener.
+  void set_socket_options(const SocketOptions& socket_options);
+  void set_socket_options(std::uint32_t reactor_index, const SocketOptions& socket_options);
+  const LoadStats& load_stats() const { return _load_stats; }
+
   void wait_for_connection();
-  std::uint32_t fetch_data(std::uint32_t max_count = -1);
-  std::uint32_t deliver_data(std::uint32_t max_count = -1);
 
 private:
-  void handle_accept(boost::system::error_code ec, boost::asio::ip::tcp::socket socket);
-  void handle_send(std::uint32_t connection_id, const message::Data& data);
-  message::Data handle_request(std::uint32_t connection_id, const message::Data& data);
+  static std::uint32_t determine_reactor_count(std::uint32_t reactor_count);
+  static constexpr bool handles_inline();
+  static constexpr bool handles_body();
+
+  void wait_for_connection(reactor::Reactor& reactor);
+  void handle_accept(reactor::Reactor& reactor, boost::system::error_code ec,
+                     boost::asio::ip::tcp::socket socket);
+  bool admit(reactor::Reactor& reactor, boost::asio::ip::tcp::socket socket);
+  void reject(boost::asio::ip::tcp::socket socket);
+  void release(reactor::Reactor& reactor, ConnectionHandle handle);
+  void pause_accept(reactor::Reactor& reactor);
+  void resume_accept(reactor::Reactor& reactor);
+  void shed(const TcpConnectionPtr& connection, std::uint32_t connection_id,
+            std::uint64_t sequence);
+  void dispatch(TcpConnectionPtr connection, message::Request request);
+  void dispatch_body(TcpConnectionPtr connection, message::Data chunk, bool last);
+  void deliver(ConnectionHandle handle, message::Payload response);
+  message::Payload handle_request(std::uint32_t connection_id, const message::Request& request);
 
   std::uint16_t _port;
+  bool _pin_reactors;
+  connection::Timeouts _timeouts;
+  connection::Limits _limits;
+  Admission _admission;
+  AcceptOptions _accept_options;
+  // Socket options of every reactor's listener.
+  std::vector<SocketOptions> _socket_options;
+  LoadStats _load_stats;
+
+  std::vector<std::unique_ptr<reactor::Reactor>> _reactors;
+  // Accept state of every reactor, only touched on its thread.
+  struct AcceptState {
+    std::uint32_t pending{0};
+    bool accepting{true};
+  };
+  std::vector<AcceptState> _accept_states;
+
+  thread::ThreadPool _worker_thread_pool;
 
-  boost::asio::io_context _io_context;
-  std::thread _io_context_thread;
+  TcpConnectionPool _connection_pool;
+};
 
-  boost::asio::ip::tcp::acceptor _acceptor;
+} // namespace web_server
 
-  utils::Queue<message::Data> _in_queue;
-  utils::Queue<message::Data> _out_queue;
+// implementation of Server class
+namespace web_server {
 
-  std::thread _fetch_thread;
-  std::thread _deliver_thread;
+template <typename T>
+Server<T>::Server(std::uint16_t port, std::uint32_t reactor_count, bool pin_reactors)
+    : _port(port), _pin_reactors(pin_reactors), _timeouts(), _limits(), _admission(),
+      _accept_options(), _socket_options(), _load_stats(), _reactors(), _accept_states(),
+      _worker_thread_pool(4), _connection_pool(20) {
+  boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::tcp::v4(), port);
+  reactor_count = determine_reactor_count(reactor_count);
+  for (std::uint32_t i = 0; i < reactor_count; ++i) {
+    _reactors.emplace_back(std::make_unique<reactor::Reactor>(i, endpoint));
+  }
+  _accept_states.resize(reactor_count);
+  _socket_options.resize(reactor_count);
+  set_admission(_admission);
+}
 
-  bool _fetch_thread_running{false};
-  bool _deliver_thread_running{false};
+template <typename T>
+void Server<T>::set_accept_options(const AcceptOptions& accept_options) {
+  _accept_options = accept_options;
+  _accept_options.pending_accepts = std::max(_accept_options.pending_accepts, 1u);
+  _accept_options.batch_size = std::max(_accept_options.batch_size, 1u);
+}
 
-  std::mutex _fetch_mutex;
-  std::mutex _deliver_mutex;
+template <typename T>
+void Server<T>::set_socket_options(const SocketOptions& socket_options) {
+  std::fill(_socket_options.begin(), _socket_options.end(), socket_options);
+}
 
-  thread::ThreadPool _receive_thread_pool;
-  thread::ThreadPool _send_thread_pool;
+template <typename T>
+void Server<T>::set_socket_options(std::uint32_t reactor_index,
+                                   const SocketOptions& socket_options) {
+  if (reactor_index < _socket_options.size()) {
+    _socket_options[reactor_index] = socket_options;
+  }
+}
 
-  thread::ThreadPool _listen_thread_pool;
+template <typename T>
+void Server<T>::set_admission(const Admission& admission) {
+  _admission = admission;
+  _admission.connection_high_watermark =
+      std::min(_admission.connection_high_watermark, _connection_pool.max_size());
+  _admission.connection_low_watermark =
+      std::min(_admission.connection_low_watermark, _admission.connection_high_watermark - 1);
+  _worker_thread_pool.set_watermarks(_admission.task_high_watermark,
+                                     _admission.task_low_watermark);
+}
 
-  TcpConnectionPool _connection_pool;
-};
+template <typename T>
+std::uint32_t Server<T>::determine_reactor_count(std::uint32_t reactor_count) {
+  if (reactor_count > 0) {
+    return reactor_count;
+  }
+  reactor_count = std::thread::hardware_concurrency();
+  return reactor_count > 0 ? reactor_count : 1;
+}
 
-} // namespace web_server
+template <typename T>
+constexpr bool Server<T>::handles_inline() {
+  if constexpr (requires { T::inline_handler; }) {
+    return T::inline_handler;
+  } else {
+    return false;
+  }
+}
 
-// implementation of Server class
-namespace web_server {
+template <typename T>
+constexpr bool Server<T>::handles_body() {
+  return requires(T& server, std::uint32_t connection_id, const message::Data& chunk,
+                  bool last) { server.implement_handle_body(connection_id, chunk, last); };
+}
 
 template <typename T>
 void Server<T>::start() {
   try {
     utils::Logger::logger().info("Server::Starting Server");
+    for (auto& reactor : _reactors) {
+      reactor->listen(_accept_options.backlog, _socket_options[reactor->index()]);
+      utils::Logger::logger().info(
+          "Server::Reactor " + std::to_string(reactor->index()) + " socket options: " +
+          reactor->socket_options().describe(reactor->acceptor()) + ".");
+    }
     wait_for_connection();
 
-    utils::Logger::logger().info("Server::Create io_context thread.");
-    _io_context_thread = std::thread([this]() { _io_context.run(); });
-
-    utils::Logger::logger().info("Server::Create fetch thread.");
-    _fetch_thread_running = true;
-    _fetch_thread = std::thread([this]() {
-      while (true) {
-        fetch_data(5);
-        std::scoped_lock<std::mutex> lock{_fetch_mutex};
-        if (!_fetch_thread_running) {
-          break;
-        }
-      }
-    });
-
-    utils::Logger::logger().info("Server::Create deliver thread.");
-    _deliver_thread_running = true;
-    _deliver_thread = std::thread([this]() {
-      while (true) {
-        deliver_data(5);
-        std::scoped_lock<std::mutex> lock{_deliver_mutex};
-        if (!_deliver_thread_running) {
-          break;
-        }
+    utils::Logger::logger().info("Server::Create " + std::to_string(_reactors.size()) +
+                                 " reactor threads.");
+    auto cpu_count = std::max(std::thread::hardware_concurrency(), 1u);
+    for (auto& reactor : _reactors) {
+      if (_pin_reactors) {
+        reactor->run(reactor->index() % cpu_count);
+      } else {
+        reactor->run();
       }
-    });
+    }
 
     utils::Logger::logger().info("Server::Server listening on " + std::to_string(_port) + ".");
   } catch (std::exception& e) {
@@ -134,37 +289,13 @@ void Server<T>::stop() {
   utils::Logger::logger().info("Server::Stopping Server.");
 
   utils::Logger::logger().info("Server::Destroy thread pools.");
-  _receive_thread_pool.destroy();
-  _send_thread_pool.destroy();
-  _listen_thread_pool.destroy();
-
-  utils::Logger::logger().info("Server::Destroy fetch thread.");
-  {
-    std::scoped_lock<std::mutex> lock{_fetch_mutex};
-    _fetch_thread_running = false;
-  }
-  if (_fetch_thread.joinable()) {
-    _fetch_thread.join();
-  }
-
-  utils::Logger::logger().info("Server::Destroy deliver thread.");
-  {
-    std::scoped_lock<std::mutex> lock{_deliver_mutex};
-    _deliver_thread_running = false;
-  }
-  if (_deliver_thread.joinable()) {
-    _deliver_thread.join();
-  }
+  _worker_thread_pool.destroy();
 
-  utils::Logger::logger().info("Server::Destroy io_context thread.");
-  _io_context.stop();
-  if (_io_context_thread.joinable()) {
-    _io_context_thread.join();
+  utils::Logger::logger().info("Server::Stop reactors and close acceptors.");
+  for (auto& reactor : _reactors) {
+    reactor->stop();
   }
 
-  utils::Logger::logger().info("Server::Close acceptor.");
-  _acceptor.close();
-
   utils::Logger::logger().info("Server::Clear connection pool.");
   _connection_pool.erase_all();
 }
@@ -172,111 +303,220 @@ void Server<T>::stop() {
 template <typename T>
 void Server<T>::wait_for_connection() {
   utils::Logger::logger().info("Server::Waiting for connection...");
-  _acceptor.async_accept(
-      std::bind(&Server::handle_accept, this, std::placeholders::_1, std::placeholders::_2));
+  for (auto& reactor : _reactors) {
+    for (std::uint32_t i = 0; i < _accept_options.pending_accepts; ++i) {
+      wait_for_connection(*reactor);
+    }
+  }
 }
 
 template <typename T>
-std::uint32_t Server<T>::fetch_data(std::uint32_t max_count) {
-  std::uint32_t count = 0;
-  while (count < max_count && !_in_queue.empty()) {
-#ifdef DEBUG
-    utils::Logger::logger().debug("Server::Registed fetch");
-#endif
-    auto ret = _receive_thread_pool.submit([this]() {
-      message::Data data{};
-      int ret = _in_queue.pop(data);
-      if (ret == -1) {
-#ifdef DEBUG
-        utils::Logger::logger().debug("Server::InQueue is empty.");
-#endif
-        return;
+void Server<T>::wait_for_connection(reactor::Reactor& reactor) {
+  ++_accept_states[reactor.index()].pending;
+  reactor.acceptor().async_accept(std::bind(&Server::handle_accept, this, std::ref(reactor),
+                                            std::placeholders::_1, std::placeholders::_2));
+}
+
+template <typename T>
+void Server<T>::handle_accept(reactor::Reactor& reactor, boost::system::error_code ec,
+                              boost::asio::ip::tcp::socket socket) {
+  auto& state = _accept_states[reactor.index()];
+  --state.pending;
+  if (ec == boost::asio::error::operation_aborted) {
+    return;
+  }
+
+  if (!ec) {
+    auto admitting = admit(reactor, std::move(socket));
+    // Drain connections already waiting in the backlog without another wakeup.
+    for (std::uint32_t i = 1; admitting && i < _accept_options.batch_size; ++i) {
+      auto next = reactor.acceptor().accept(reactor.io_context(), ec);
+      if (ec) {
+        break;
       }
-#ifdef DEBUG
-      utils::Logger::logger().debug("Server::Fetched data: " + data.to_string());
-      utils::Logger::logger().debug("Server::InQueue remain: " + std::to_string(_in_queue.size()));
-#endif
-      auto res = handle_request(data.connection_id(), data);
-      _out_queue.push(res);
-    });
-    ++count;
+      admitting = admit(reactor, std::move(next));
+    }
+    if (!admitting) {
+      pause_accept(reactor);
+    }
+  } else {
+    utils::Logger::logger().error(ec.message());
+  }
+
+  if (state.accepting) {
+    wait_for_connection(reactor);
   }
-  return count;
 }
 
+// Creates the connection for an accepted socket. Returns false once the
+// connection high watermark is reached.
 template <typename T>
-std::uint32_t Server<T>::deliver_data(std::uint32_t max_count) {
-  std::uint32_t count = 0;
-  while (count < max_count && !_out_queue.empty()) {
-#ifdef DEBUG
-    utils::Logger::logger().debug("Server::Registed deliver");
-#endif
-    auto ret = _send_thread_pool.submit([this]() {
-      message::Data data{};
-      int ret = _out_queue.pop(data);
-      if (ret == -1) {
-#ifdef DEBUG
-        utils::Logger::logger().debug("Server::OutQueue is empty.");
-#endif
-        return;
-      }
+bool Server<T>::admit(reactor::Reactor& reactor, boost::asio::ip::tcp::socket socket) {
+  reactor.socket_options().apply(socket);
+  auto id = _connection_pool.emplace(
+      reactor.io_context(), std::move(socket),
+      std::bind(&Server::dispatch, this, std::placeholders::_1, std::placeholders::_2));
+  auto connection = _connection_pool.get_connection(id);
+  if (connection == nullptr) {
+    utils::Logger::logger().error("Server::Connection pool is full.");
+    reject(std::move(socket));
+  } else {
 #ifdef DEBUG
-      utils::Logger::logger().debug("Server::Delivering data: " + data.to_string());
-      utils::Logger::logger().debug("Server::OutQueue remain: " +
-                                    std::to_string(_out_queue.size()));
+    utils::Logger::logger().debug("Server::Connection " + std::to_string(id) +
+                                  " accepted on reactor " + std::to_string(reactor.index()) +
+                                  ".");
 #endif
-      handle_send(data.connection_id(), data);
+    // We are already on the reactor thread that owns the connection.
+    connection->set_handle(_connection_pool.handle(id));
+    connection->set_timeouts(_timeouts);
+    connection->set_limits(_limits);
+    // File reads a response already committed to are not shed, so they
+    // bypass the watermarks of the worker queue.
+    connection->set_file_thread_pool(&_worker_thread_pool);
+    if constexpr (handles_body()) {
+      connection->set_body_handler(std::bind(&Server::dispatch_body, this, std::placeholders::_1,
+                                             std::placeholders::_2, std::placeholders::_3));
+    }
+    connection->set_pipeline_watermarks(_admission.pipeline_high_watermark,
+                                        _admission.pipeline_low_watermark);
+    connection->set_close_handler([this, &reactor, handle = connection->handle()]() {
+      // Posted: the pool may hold the last reference to the closing connection.
+      boost::asio::post(reactor.io_context(),
+                        [this, &reactor, handle]() { release(reactor, handle); });
     });
-    ++count;
+    connection->receive(id);
   }
-  return count;
+  return _connection_pool.size() < _admission.connection_high_watermark;
 }
 
+// Answers 503 on a connection the pool has no room for.
 template <typename T>
-void Server<T>::handle_accept(boost::system::error_code ec, boost::asio::ip::tcp::socket socket) {
-  if (!ec) {
-    utils::Logger::logger().info("Server::New connection accepted.");
-    auto id = _connection_pool.emplace(_io_context, std::move(socket), _in_queue);
-    if (id < 0) {
-      utils::Logger::logger().error("Server::Connection pool is full.");
-    } else {
-      utils::Logger::logger().info("Server::Created Connection id: " + std::to_string(id));
-      auto ret = _listen_thread_pool.submit(
-          [this, id]() { _connection_pool.get_connection(id)->receive(id); });
-    }
-  } else {
-    utils::Logger::logger().error(ec.message());
+void Server<T>::reject(boost::asio::ip::tcp::socket socket) {
+  ++_load_stats.rejected_connections;
+  boost::system::error_code ec;
+  // A fresh socket has room for the response; never block the reactor on it.
+  socket.non_blocking(true, ec);
+  boost::asio::write(socket, boost::asio::buffer(assets::SERVICE_UNAVAILABLE_RESPONSE), ec);
+  socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+  socket.close(ec);
+}
+
+// Frees the pool slot of a closed connection right away.
+template <typename T>
+void Server<T>::release(reactor::Reactor& reactor, ConnectionHandle handle) {
+  _connection_pool.erase(handle);
+  if (!_accept_states[reactor.index()].accepting &&
+      _connection_pool.size() <= _admission.connection_low_watermark) {
+    resume_accept(reactor);
   }
-  wait_for_connection();
 }
 
+// Stops re-arming accepts; those still pending complete as usual.
 template <typename T>
-void Server<T>::handle_send(std::uint32_t connection_id, const message::Data& data) {
-  utils::Logger::logger().info("Server::Handling response.");
-  utils::Logger::logger().info("Server::Reveal connection id: " + std::to_string(connection_id) +
-                               ".");
-  auto connection = _connection_pool.get_connection(connection_id);
-  if (connection) {
-    connection->send(data);
+void Server<T>::pause_accept(reactor::Reactor& reactor) {
+  auto& state = _accept_states[reactor.index()];
+  if (!state.accepting) {
+    return;
+  }
+  state.accepting = false;
+  ++_load_stats.accept_pauses;
+  utils::Logger::logger().warning("Server::Connection limit reached, reactor " +
+                                  std::to_string(reactor.index()) + " stops accepting.");
+  boost::asio::use_service<reactor::TimerService>(reactor.io_context())
+      .schedule(reactor::TimerService::TICK, [this, &reactor]() { resume_accept(reactor); });
+}
+
+template <typename T>
+void Server<T>::resume_accept(reactor::Reactor& reactor) {
+  auto& state = _accept_states[reactor.index()];
+  if (state.accepting) {
+    return;
+  }
+  if (_connection_pool.size() > _admission.connection_low_watermark) {
+    boost::asio::use_service<reactor::TimerService>(reactor.io_context())
+        .schedule(reactor::TimerService::TICK, [this, &reactor]() { resume_accept(reactor); });
+    return;
+  }
+  utils::Logger::logger().info("Server::Reactor " + std::to_string(reactor.index()) +
+                               " resumes accepting.");
+  state.accepting = true;
+  while (state.pending < _accept_options.pending_accepts) {
+    wait_for_connection(reactor);
+  }
+}
+
+// Answers 503 in place of handling the request.
+template <typename T>
+void Server<T>::shed(const TcpConnectionPtr& connection, std::uint32_t connection_id,
+                     std::uint64_t sequence) {
+  ++_load_stats.shed_requests;
+  message::Payload response{connection_id};
+  response.append(message::Buffer::view(assets::SERVICE_UNAVAILABLE_RESPONSE));
+  response.set_sequence(sequence);
+  connection->deliver(std::move(response));
+}
+
+template <typename T>
+void Server<T>::dispatch(TcpConnectionPtr connection, message::Request request) {
+#ifdef DEBUG
+  utils::Logger::logger().debug("Server::Dispatch request for " +
+                                std::string(request.header().path()));
+#endif
+  if constexpr (handles_inline()) {
+    auto response = handle_request(request.connection_id(), request);
+    response.set_sequence(request.sequence());
+    connection->deliver(std::move(response));
   } else {
-    utils::Logger::logger().error("Server::Connection id: " + std::to_string(connection_id) +
-                                  " does not exist.");
+    auto handle = connection->handle();
+    auto& io_context = connection->io_context();
+    auto connection_id = request.connection_id();
+    auto sequence = request.sequence();
+    auto queued = _worker_thread_pool.try_push_task(
+        [this, handle, &io_context, request = std::move(request)]() {
+          auto response = handle_request(request.connection_id(), request);
+          response.set_sequence(request.sequence());
+          boost::asio::post(io_context, [this, handle, response = std::move(response)]() mutable {
+            deliver(handle, std::move(response));
+          });
+        });
+    if (!queued) {
+      shed(connection, connection_id, sequence);
+    }
   }
 }
 
 template <typename T>
-message::Data Server<T>::handle_request(std::uint32_t connection_id, const message::Data& data) {
+void Server<T>::dispatch_body(TcpConnectionPtr connection, message::Data chunk, bool last) {
+#ifdef DEBUG
+  utils::Logger::logger().debug("Server::Dispatch body chunk of " + std::to_string(chunk.size()) +
+                                " bytes.");
+#endif
+  static_cast<T*>(this)->implement_handle_body(chunk.connection_id(), chunk, last);
+}
+
+template <typename T>
+void Server<T>::deliver(ConnectionHandle handle, message::Payload response) {
+  // Runs on the connection's reactor, the only thread that erases it, so
+  // the connection outlives this call; it takes its own reference when the
+  // response reaches its strand.
+  auto connection = _connection_pool.resolve(handle);
+  if (connection == nullptr) {
+#ifdef DEBUG
+    utils::Logger::logger().debug("Server::Drop response to closed connection " +
+                                  std::to_string(handle & 0xffffffff) + ".");
+#endif
+    return;
+  }
+  connection->deliver(std::move(response));
+}
+
+template <typename T>
+message::Payload Server<T>::handle_request(std::uint32_t connection_id,
+                                           const message::Request& request) {
   utils::Logger::logger().info("Server::Handling request.");
   utils::Logger::logger().info("Server::Reveal connection id: " + std::to_string(connection_id) +
                                ".");
-  auto connection = _connection_pool.get_connection(connection_id);
-  if (connection) {
-    return static_cast<T*>(this)->implement_handle_request(connection_id, data);
-  } else {
-    utils::Logger::logger().error("Server::Connection id: " + std::to_string(connection_id) +
-                                  " does not exist.");
-    return message::Data();
-  }
+  return static_cast<T*>(this)->implement_handle_request(connection_id, request);
 }
 
 } // namespace web_server
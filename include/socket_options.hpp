@@ -0,0 +1,50 @@
+/*
+ * SocketOptions struct
+ * TCP tuning of a listener and of the sockets it accepts. Options that the
+ * kernel copies from the listener to accepted sockets (buffer sizes, busy
+ * polling) only cost a system call per listener; TCP_NODELAY and
+ * TCP_QUICKACK are set again on every accepted socket.
+ *
+ * Options a platform lacks are skipped. Failing to set an option on the
+ * listener is logged as a warning, on an accepted socket it is ignored.
+ */
+#ifndef SOCKET_OPTIONS_H_
+#define SOCKET_OPTIONS_H_
+
+#include <boost/asio.hpp>
+#include <string>
+
+namespace web_server {
+namespace reactor {
+
+struct SocketOptions {
+  // Disables Nagle's algorithm, so a small response is not held back until
+  // the previous segment is acknowledged.
+  bool no_delay{true};
+  // Seconds the kernel holds a new connection until its first data arrives,
+  // so the acceptor is not woken for idle connections. 0 disables it.
+  int defer_accept{0};
+  // Pending TCP Fast Open requests of the listener. 0 disables it.
+  int fast_open_queue{0};
+  // Socket buffer sizes in bytes. 0 keeps the system default.
+  int receive_buffer{0};
+  int send_buffer{0};
+  // Acknowledges right away instead of delaying ACKs. The kernel clears it
+  // again on its own, so it only helps the first exchanges of a connection.
+  bool quick_ack{false};
+  // Microseconds to busy poll the device queue on reads. 0 disables it.
+  int busy_poll{0};
+
+  // Must be called between bind and listen.
+  void apply(boost::asio::ip::tcp::acceptor& acceptor) const;
+  void apply(boost::asio::ip::tcp::socket& socket) const;
+
+  // The options in effect on the listener, as reported by the kernel, and
+  // those only set on accepted sockets.
+  std::string describe(boost::asio::ip::tcp::acceptor& acceptor) const;
+};
+
+} // namespace reactor
+} // namespace web_server
+
+#endif // SOCKET_OPTIONS_H_
@@ -2,11 +2,18 @@
 #define STATIC_SERVER_H_
 
 #include "assets.hpp"
+#include "byte_range.hpp"
+#include "content_coding.hpp"
+#include "file_cache.hpp"
+#include "mime_type.hpp"
+#include "payload.hpp"
 #include "request.hpp"
 #include "server.hpp"
 
+#include <ctime>
 #include <filesystem>
-#include <fstream>
+#include <memory>
+#include <optional>
 
 namespace web_server {
 
@@ -14,19 +21,86 @@ class StaticServer: public Server<StaticServer> {
   friend class Server<StaticServer>;
 
 public:
-  StaticServer(std::uint16_t port, std::filesystem::path root_path, bool custom_error_page = false)
-      : Server(port), _root_path(root_path), _custom_error_page(custom_error_page) {}
+  StaticServer(std::uint16_t port, std::filesystem::path root_path, bool custom_error_page = false,
+               std::uint32_t reactor_count = 0, bool pin_reactors = false)
+      : Server(port, reactor_count, pin_reactors), _root_path(canonical_root(root_path)),
+        _custom_error_page(custom_error_page), _boundary(generate_boundary()),
+        _cache(std::make_unique<message::FileCache>(_root_path)) {}
+
+  // Replaces the file cache; a capacity of 0 disables it. Must be called
+  // before start().
+  void set_file_cache(const message::FileCacheOptions& options) {
+    _cache = std::make_unique<message::FileCache>(_root_path, options);
+  }
+  const message::FileCache& file_cache() const { return *_cache; }
+
+  // Answers one request; the server calls it on a worker thread.
+  message::Payload implement_handle_request(std::uint32_t connection_id,
+                                            const message::Request& request);
 
 private:
+  // Canonical, so that request paths below it can be cached.
   std::filesystem::path _root_path;
   bool _custom_error_page;
-  std::uint32_t file_size(std::fstream& file);
-  std::uint32_t generate_header(std::stringstream& header_ss, const std::string& response_line,
-                                std::uint32_t content_size);
-  message::Data read_file(std::fstream& file, std::uint32_t content_size,
-                          std::uint32_t connection_id, std::stringstream& header_ss,
-                          std::uint32_t header_size);
-  message::Data implement_handle_request(std::uint32_t connection_id, const message::Data& request);
+  // Separates the parts of multipart/byteranges responses.
+  std::string _boundary;
+  // Hot files with their response headers; a hit costs no system call.
+  std::unique_ptr<message::FileCache> _cache;
+
+  // What is sent for a file: the file itself or a precompressed sibling.
+  struct Representation {
+    std::filesystem::path path;
+    message::FileMetadata metadata;
+    std::string_view content_type;
+    // The Content-Encoding, empty for identity.
+    std::string_view coding;
+    // The file's type is compressible, so the response depends on Accept-Encoding.
+    bool vary{false};
+  };
+
+  static std::filesystem::path canonical_root(const std::filesystem::path& root_path);
+
+  static std::string generate_boundary();
+  // fields are extra header lines, each ending in CRLF. The header is
+  // built in one allocation, starting with the prebuilt status line.
+  std::string generate_header(std::uint32_t status_code, std::uint64_t content_size,
+                              std::string_view content_type = "text/html",
+                              std::string_view fields = {});
+  // The header is sent from memory, the file body with sendfile(2).
+  message::Payload file_response(std::shared_ptr<const message::File> file,
+                                 std::uint32_t connection_id, std::uint32_t status_code,
+                                 std::string_view fields = {},
+                                 std::string_view content_type = "text/html");
+  // Answers a Range request with 206, a multipart/byteranges 206 or 416;
+  // only the requested ranges of the file are read.
+  message::Payload range_response(std::shared_ptr<const message::File> file,
+                                  std::uint32_t connection_id, std::string_view range,
+                                  const std::string& fields, std::string_view content_type);
+  // Answers GET and HEAD requests from a cached file. Returns nullopt for
+  // requests the cache cannot answer, such as Range requests.
+  std::optional<message::Payload> cached_response(message::FileCache::Entry file,
+                                                  std::uint32_t connection_id,
+                                                  const message::RequestHeader& header);
+  // A response without a body, for HEAD and 304, built from file metadata only.
+  static message::Payload header_response(std::uint32_t connection_id,
+                                          std::uint32_t status_code, std::string_view fields);
+  // Switches file to the precompressed sibling of the best coding accepted.
+  static void select_sibling(Representation& file, const message::AcceptedCodings& accepted);
+
+  // Accept-Ranges, Last-Modified, ETag and, if vary, Vary header lines.
+  static std::string validator_fields(const message::FileMetadata& metadata,
+                                      const std::string& entity_tag, bool vary);
+  // Strong unless the file changed within the last second, when another
+  // change in the same second would leave its metadata the same. Every
+  // coding of a file has its own tag.
+  static std::string entity_tag(const message::FileMetadata& metadata,
+                                std::string_view coding = {});
+  // If-None-Match, or else If-Modified-Since, says the client's copy is current.
+  static bool not_modified(const message::RequestHeader& header, const std::string& entity_tag,
+                           std::time_t modified);
+  // If-Range holds a validator; the range applies only if it still matches.
+  static bool if_range_matches(const message::RequestHeader& header,
+                               const message::FileMetadata& metadata);
 };
 
 } // namespace web_server
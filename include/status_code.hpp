@@ -0,0 +1,149 @@
+/*
+ * Status codes
+ * The registered status codes and their reason phrases (RFC 9110, section
+ * 15). The HTTP/1.1 status line of every code is built at compile time, so
+ * a response header starts with a single copy from a constant.
+ */
+#ifndef STATUS_CODE_H_
+#define STATUS_CODE_H_
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace web_server {
+namespace message {
+
+struct StatusCode {
+  std::uint16_t code;
+  std::string_view reason;
+};
+
+inline constexpr std::array<StatusCode, 49> STATUS_CODES{{
+    {100, "Continue"},
+    {101, "Switching Protocols"},
+    {200, "OK"},
+    {201, "Created"},
+    {202, "Accepted"},
+    {203, "Non-Authoritative Information"},
+    {204, "No Content"},
+    {205, "Reset Content"},
+    {206, "Partial Content"},
+    {300, "Multiple Choices"},
+    {301, "Moved Permanently"},
+    {302, "Found"},
+    {303, "See Other"},
+    {304, "Not Modified"},
+    {305, "Use Proxy"},
+    {307, "Temporary Redirect"},
+    {308, "Permanent Redirect"},
+    {400, "Bad Request"},
+    {401, "Unauthorized"},
+    {402, "Payment Required"},
+    {403, "Forbidden"},
+    {404, "Not Found"},
+    {405, "Method Not Allowed"},
+    {406, "Not Acceptable"},
+    {407, "Proxy Authentication Required"},
+    {408, "Request Timeout"},
+    {409, "Conflict"},
+    {410, "Gone"},
+    {411, "Length Required"},
+    {412, "Precondition Failed"},
+    {413, "Content Too Large"},
+    {414, "URI Too Long"},
+    {415, "Unsupported Media Type"},
+    {416, "Range Not Satisfiable"},
+    {417, "Expectation Failed"},
+    {421, "Misdirected Request"},
+    {422, "Unprocessable Content"},
+    {426, "Upgrade Required"},
+    {428, "Precondition Required"},
+    {429, "Too Many Requests"},
+    {431, "Request Header Fields Too Large"},
+    {451, "Unavailable For Legal Reasons"},
+    {500, "Internal Server Error"},
+    {501, "Not Implemented"},
+    {502, "Bad Gateway"},
+    {503, "Service Unavailable"},
+    {504, "Gateway Timeout"},
+    {505, "HTTP Version Not Supported"},
+    {511, "Network Authentication Required"},
+}};
+
+namespace detail {
+
+inline constexpr std::string_view STATUS_LINE_VERSION = "HTTP/1.1 ";
+
+constexpr std::size_t status_lines_size() {
+  std::size_t size = 0;
+  for (const auto& status : STATUS_CODES) {
+    size += STATUS_LINE_VERSION.size() + 4 + status.reason.size() + 2;
+  }
+  return size;
+}
+
+// Every status line back to back, and where the line of each code from 100
+// to 599 starts; unregistered codes have an empty line.
+struct StatusLines {
+  std::array<char, status_lines_size()> bytes{};
+  std::array<std::uint16_t, 501> offsets{};
+};
+
+constexpr StatusLines make_status_lines() {
+  StatusLines lines{};
+  std::size_t size = 0;
+  auto append = [&lines, &size](std::string_view part) {
+    for (char c : part) {
+      lines.bytes[size++] = c;
+    }
+  };
+  std::size_t next = 0;
+  for (std::size_t code = 100; code < 600; ++code) {
+    lines.offsets[code - 100] = static_cast<std::uint16_t>(size);
+    if (next == STATUS_CODES.size() || STATUS_CODES[next].code != code) {
+      continue;
+    }
+    const char digits[] = {static_cast<char>('0' + code / 100),
+                           static_cast<char>('0' + code / 10 % 10),
+                           static_cast<char>('0' + code % 10), ' '};
+    append(STATUS_LINE_VERSION);
+    append({digits, 4});
+    append(STATUS_CODES[next].reason);
+    append("\r\n");
+    ++next;
+  }
+  lines.offsets[500] = static_cast<std::uint16_t>(size);
+  return lines;
+}
+
+inline constexpr StatusLines STATUS_LINES = make_status_lines();
+static_assert(STATUS_LINES.offsets[500] == STATUS_LINES.bytes.size(),
+              "STATUS_CODES must be sorted by code");
+
+} // namespace detail
+
+// "HTTP/1.1 200 OK\r\n" for a registered code, or an empty view.
+constexpr std::string_view status_line(std::uint32_t code) {
+  if (code < 100 || code > 599) {
+    return {};
+  }
+  const auto& lines = detail::STATUS_LINES;
+  return {lines.bytes.data() + lines.offsets[code - 100],
+          static_cast<std::size_t>(lines.offsets[code - 99] - lines.offsets[code - 100])};
+}
+
+// The reason phrase of a registered code, or an empty view.
+constexpr std::string_view reason_phrase(std::uint32_t code) {
+  auto line = status_line(code);
+  if (line.empty()) {
+    return {};
+  }
+  auto prefix = detail::STATUS_LINE_VERSION.size() + 4;
+  return line.substr(prefix, line.size() - prefix - 2);
+}
+
+} // namespace message
+} // namespace web_server
+
+#endif // STATUS_CODE_H_
@@ -1,3 +1,7 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <algorithm>
 #include <condition_variable>
 #include <cstdint>
 #include <exception>
@@ -43,6 +47,41 @@ public:
     _task_available_cv.notify_one();
   }
 
+  // Bounds the task queue for try_push_task(): once it holds high_watermark
+  // tasks, new tasks are rejected until it drains to low_watermark.
+  // A high watermark of 0 leaves the queue unbounded.
+  void set_watermarks(std::size_t high_watermark, std::size_t low_watermark) {
+    std::scoped_lock<std::mutex> lock{_task_mutex};
+    _high_watermark = high_watermark;
+    _low_watermark = std::min(low_watermark, high_watermark);
+    _saturated = false;
+  }
+
+  // Like push_task(), but returns false instead of queueing past the high watermark.
+  template <typename F, typename... Args>
+  [[nodiscard]] bool try_push_task(F&& f, Args&&... args) {
+    {
+      std::scoped_lock<std::mutex> lock{_task_mutex};
+      if (_high_watermark > 0) {
+        if (_saturated && _tasks.size() > _low_watermark) {
+          return false;
+        }
+        _saturated = _tasks.size() >= _high_watermark;
+        if (_saturated) {
+          return false;
+        }
+      }
+      _tasks.emplace(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    }
+    _task_available_cv.notify_one();
+    return true;
+  }
+
+  std::size_t queued_tasks() const {
+    std::scoped_lock<std::mutex> lock{_task_mutex};
+    return _tasks.size();
+  }
+
   template <typename F, typename... Args,
             typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>
   [[nodiscard]] std::future<R> submit(F&& task, Args&&... args) {
@@ -143,6 +182,7 @@ private:
   }
 
   bool _pause{};
+  bool _saturated{false};
   bool _workers_running{false};
   bool _wait_for_tasks{false};
 
@@ -153,9 +193,13 @@ private:
 
   std::uint32_t _thread_count{};
   std::uint32_t _running_tasks{};
+  std::size_t _high_watermark{0};
+  std::size_t _low_watermark{0};
   std::unique_ptr<std::thread[]> _threads{};
   std::queue<std::function<void()>> _tasks{};
 };
 
 } // namespace thread
 } // namespace web_server
+
+#endif // THREAD_POOL_H_
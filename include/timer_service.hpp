@@ -0,0 +1,57 @@
+/*
+ * TimerService class
+ * One timing wheel per io_context, so every reactor keeps the timeouts of
+ * its own connections. The wheel is advanced by a single steady_timer that
+ * only runs while timers are pending.
+ *
+ * Get it with boost::asio::use_service<TimerService>(io_context). Timers can
+ * be scheduled and cancelled from any thread; callbacks run on a thread
+ * running the io_context, after the service has released its lock.
+ */
+#ifndef TIMER_SERVICE_H_
+#define TIMER_SERVICE_H_
+
+#include "timing_wheel.hpp"
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace web_server {
+namespace reactor {
+
+class TimerService: public boost::asio::execution_context::service {
+public:
+  using Clock = TimingWheel::Clock;
+  using Callback = TimingWheel::Callback;
+  using TimerId = TimingWheel::TimerId;
+
+  static inline boost::asio::execution_context::id id;
+  static constexpr Clock::duration TICK = std::chrono::milliseconds(100);
+
+  explicit TimerService(boost::asio::io_context& io_context);
+
+  TimerId schedule(Clock::duration timeout, Callback callback);
+  // Cancelling a timer that already fired or was cancelled does nothing.
+  void cancel(TimerId id);
+
+  std::size_t size() const;
+
+private:
+  void shutdown() override;
+  void arm();
+  void handle_tick(boost::system::error_code ec);
+
+  mutable std::mutex _mutex;
+  TimingWheel _wheel;
+  boost::asio::steady_timer _timer;
+  bool _armed{false};
+  bool _shutdown{false};
+  std::vector<Callback> _expired;
+};
+
+} // namespace reactor
+} // namespace web_server
+
+#endif // TIMER_SERVICE_H_
@@ -0,0 +1,93 @@
+/*
+ * TimingWheel class
+ * A hierarchical timing wheel: LEVELS wheels of SLOTS slots each, where a
+ * slot of level n spans SLOTS^n ticks. A timer is linked into the slot its
+ * expiry falls in; when a lower wheel wraps around, the next slot of the
+ * wheel above is cascaded down. Scheduling and cancelling are O(1) and a
+ * tick only touches the timers that expire or cascade in it, no matter how
+ * many timers are pending.
+ *
+ * Timers live in one vector and slots are intrusive lists of indices into
+ * it, so a steady state of scheduling and cancelling does not allocate.
+ * The wheel is not thread safe.
+ */
+#ifndef TIMING_WHEEL_H_
+#define TIMING_WHEEL_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace web_server {
+namespace reactor {
+
+class TimingWheel {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Callback = std::function<void()>;
+  // Identifies a scheduled timer. Ids of fired or cancelled timers are never reused.
+  using TimerId = std::uint64_t;
+  static constexpr TimerId INVALID_TIMER = 0;
+
+  TimingWheel() = delete;
+  TimingWheel(Clock::duration tick, Clock::time_point start = Clock::now());
+  TimingWheel(const TimingWheel&) = delete;
+  TimingWheel(TimingWheel&&) = delete;
+  TimingWheel& operator=(const TimingWheel&) = delete;
+  TimingWheel& operator=(TimingWheel&&) = delete;
+  ~TimingWheel() = default;
+
+  // The timer expires no earlier than timeout from the current tick and at
+  // most one tick later. Timeouts beyond the span of the wheel are clamped.
+  TimerId schedule(Clock::duration timeout, Callback callback);
+  // Returns false if the timer already fired or was cancelled.
+  bool cancel(TimerId id);
+  // Advances the wheel to now and appends the callbacks of every expired
+  // timer to expired, tick by tick. Returns the number of expired timers.
+  std::size_t advance(Clock::time_point now, std::vector<Callback>& expired);
+  void clear();
+
+  Clock::duration tick() const { return _tick; }
+  std::size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+
+private:
+  static constexpr std::uint32_t SLOT_BITS = 6;
+  static constexpr std::uint32_t SLOTS = 1u << SLOT_BITS;
+  static constexpr std::uint32_t LEVELS = 4;
+  static constexpr std::uint64_t MAX_TICKS = (1ull << (SLOT_BITS * LEVELS)) - 1;
+  static constexpr std::uint32_t NIL = std::numeric_limits<std::uint32_t>::max();
+
+  struct Timer {
+    Callback callback{};
+    std::uint64_t expiry{0};
+    std::uint32_t generation{1};
+    std::uint32_t prev{NIL};
+    std::uint32_t next{NIL};
+    // level * SLOTS + slot, NIL while the timer is unused.
+    std::uint32_t slot{NIL};
+  };
+
+  void place(std::uint32_t index);
+  void link(std::uint32_t index, std::uint32_t slot);
+  void unlink(std::uint32_t index);
+  void release(std::uint32_t index);
+  void cascade(std::uint32_t level);
+
+  Clock::duration _tick;
+  Clock::time_point _start;
+  std::uint64_t _current_tick{0};
+
+  std::vector<Timer> _timers{};
+  std::uint32_t _free{NIL};
+  std::array<std::uint32_t, LEVELS * SLOTS> _slots{};
+  std::size_t _size{0};
+};
+
+} // namespace reactor
+} // namespace web_server
+
+#endif // TIMING_WHEEL_H_
@@ -1,18 +1,56 @@
 #ifndef UTILS_H_
 #define UTILS_H_
 
+#include <ctime>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace web_server {
 namespace utils {
 
-
+// Reads the line at *start up to its CRLF and moves *start past it. Returns
+// -1 for an empty line, or with *start at the end if no CRLF follows.
 [[nodiscard]] int get_line(std::string_view data, std::string_view& line, int* start);
 
+// Splits a start line into at most three words at its first two spaces.
 void split_line(std::string_view line, std::vector<std::string_view>& words);
 
+// Splits a header line at its colon; value is empty if there is none.
 void split_head(std::string_view line, std::string_view& key, std::string_view& value);
 
+constexpr char to_lower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c; }
+
+// Compares ASCII strings ignoring case, as for field names and tokens.
+inline bool equals_ignore_case(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (to_lower(a[i]) != to_lower(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Strips the optional whitespace (spaces and tabs) around a field value or
+// list element.
+inline std::string_view trim(std::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+    value.remove_prefix(1);
+  }
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+    value.remove_suffix(1);
+  }
+  return value;
+}
+
+// Formats a time as an HTTP-date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+std::string http_date(std::time_t time);
+// Parses an HTTP-date in the preferred format. Returns false if malformed.
+bool parse_http_date(std::string_view date, std::time_t& time);
+
 
 } // namespace utils
 } // namespace web_server
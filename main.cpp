@@ -1,5 +1,7 @@
 #include "include/static_server.hpp"
 #include <atomic>
+#include <cstdlib>
+#include <limits>
 #include <signal.h>
 
 std::atomic<bool> quit{false};
@@ -19,13 +21,22 @@ int main(int argc, char** argv) {
   sigaction(SIGINT, &sigint_action, nullptr);
 
   using namespace web_server;
-  if (argc != 2) {
-    std::cerr << "Usage: " << argv[0] << " <root directory>" << std::endl;
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <root directory> [port]" << std::endl;
     exit(1);
   }
   std::filesystem::path root_dir{argv[1]};
+  std::uint16_t port = 8080;
+  if (argc == 3) {
+    auto value = std::strtoul(argv[2], nullptr, 10);
+    if (value == 0 || value > std::numeric_limits<std::uint16_t>::max()) {
+      std::cerr << "Invalid port: " << argv[2] << std::endl;
+      exit(1);
+    }
+    port = static_cast<std::uint16_t>(value);
+  }
   utils::Logger::logger().info("main::Root directory: " + root_dir.string());
-  StaticServer server{8080, root_dir};
+  StaticServer server{port, root_dir};
   server.start();
   for (;;) {
     if (quit) {
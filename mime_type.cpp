@@ -0,0 +1,91 @@
+#include "include/mime_type.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <utility>
+
+namespace web_server {
+namespace message {
+
+namespace {
+
+// Sorted by extension, for binary search.
+constexpr std::array<std::pair<std::string_view, std::string_view>, 36> MIME_TYPES{{
+    {"avif", "image/avif"},
+    {"bmp", "image/bmp"},
+    {"css", "text/css"},
+    {"csv", "text/csv"},
+    {"gif", "image/gif"},
+    {"gz", "application/gzip"},
+    {"htm", "text/html"},
+    {"html", "text/html"},
+    {"ico", "image/x-icon"},
+    {"jpeg", "image/jpeg"},
+    {"jpg", "image/jpeg"},
+    {"js", "text/javascript"},
+    {"json", "application/json"},
+    {"map", "application/json"},
+    {"md", "text/markdown"},
+    {"mjs", "text/javascript"},
+    {"mp3", "audio/mpeg"},
+    {"mp4", "video/mp4"},
+    {"oga", "audio/ogg"},
+    {"ogg", "audio/ogg"},
+    {"otf", "font/otf"},
+    {"pdf", "application/pdf"},
+    {"png", "image/png"},
+    {"svg", "image/svg+xml"},
+    {"tar", "application/x-tar"},
+    {"ttf", "font/ttf"},
+    {"txt", "text/plain"},
+    {"wasm", "application/wasm"},
+    {"wav", "audio/wav"},
+    {"webm", "video/webm"},
+    {"webmanifest", "application/manifest+json"},
+    {"webp", "image/webp"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"xml", "application/xml"},
+    {"zip", "application/zip"},
+}};
+
+static_assert(std::is_sorted(MIME_TYPES.begin(), MIME_TYPES.end()));
+
+// Compressible types besides text/*.
+constexpr std::array<std::string_view, 9> COMPRESSIBLE_TYPES{
+    "application/json", "application/manifest+json", "application/wasm",
+    "application/xml",  "font/otf",                  "font/ttf",
+    "image/bmp",        "image/svg+xml",             "image/x-icon",
+};
+
+} // namespace
+
+std::string_view mime_type(const std::filesystem::path& path) {
+  const auto& name = path.native();
+  auto dot = name.rfind('.');
+  if (dot == std::string::npos || name.find('/', dot) != std::string::npos) {
+    return DEFAULT_MIME_TYPE;
+  }
+  auto extension = std::string_view(name).substr(dot + 1);
+  char lower[16];
+  if (extension.empty() || extension.size() > sizeof(lower)) {
+    return DEFAULT_MIME_TYPE;
+  }
+  std::transform(extension.begin(), extension.end(), lower,
+                 [](char c) { return std::tolower(static_cast<unsigned char>(c)); });
+  std::string_view key{lower, extension.size()};
+  auto it = std::lower_bound(
+      MIME_TYPES.begin(), MIME_TYPES.end(), key,
+      [](const auto& entry, std::string_view extension) { return entry.first < extension; });
+  return it != MIME_TYPES.end() && it->first == key ? it->second : DEFAULT_MIME_TYPE;
+}
+
+bool is_compressible(std::string_view mime_type) {
+  return mime_type.starts_with("text/") ||
+         std::find(COMPRESSIBLE_TYPES.begin(), COMPRESSIBLE_TYPES.end(), mime_type) !=
+             COMPRESSIBLE_TYPES.end();
+}
+
+} // namespace message
+} // namespace web_server
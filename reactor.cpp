@@ -0,0 +1,65 @@
+#include "include/reactor.hpp"
+#include "include/logger.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace web_server {
+namespace reactor {
+
+Reactor::Reactor(std::uint32_t index, const boost::asio::ip::tcp::endpoint& endpoint)
+    : _index(index), _io_context(1), _work_guard(boost::asio::make_work_guard(_io_context)),
+      _acceptor(_io_context), _socket_options() {
+  _acceptor.open(endpoint.protocol());
+  _acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+  _acceptor.set_option(ReusePort(true));
+  _acceptor.bind(endpoint);
+}
+
+void Reactor::listen(int backlog, const SocketOptions& socket_options) {
+  _socket_options = socket_options;
+  _socket_options.apply(_acceptor);
+  _acceptor.listen(backlog);
+  // Lets the accept loop drain the backlog until it would block.
+  _acceptor.non_blocking(true);
+}
+
+void Reactor::run(std::optional<std::uint32_t> cpu) {
+  _thread = std::thread([this, cpu]() {
+    if (cpu) {
+      pin_to_cpu(*cpu);
+    }
+    _io_context.run();
+  });
+}
+
+void Reactor::stop() {
+  _work_guard.reset();
+  _io_context.stop();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+
+  boost::system::error_code ec;
+  _acceptor.close(ec);
+}
+
+void Reactor::pin_to_cpu(std::uint32_t cpu) {
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (ret != 0) {
+    utils::Logger::logger().warning("Reactor::Failed to pin reactor to cpu " +
+                                    std::to_string(cpu) + ".");
+  }
+#else
+  utils::Logger::logger().warning("Reactor::CPU pinning is not supported on this platform.");
+#endif
+}
+
+} // namespace reactor
+} // namespace web_server
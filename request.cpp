@@ -1,13 +1,35 @@
 #include "include/request.hpp"
+#include "include/request_parser.hpp"
 
 namespace web_server {
 namespace message {
 
-Request::Request(const DataView& data) {
+Request::Request(const DataView& data): _connection_id(data.connection_id()) {
   int start = _header.parse(data);
   auto sub_data = data.subdata(start, std::string::npos);
 
-  _body = std::string((char*)sub_data.data(), sub_data.size());
+  _body = Buffer(nullptr, sub_data.data(), sub_data.size());
+}
+
+Request::Request(Data&& data): _connection_id(data.connection_id()), _sequence(data.sequence()) {
+  int start = _header.parse(data);
+
+  _body = Buffer::own(std::move(data)).slice(start);
+}
+
+Request::Request(Data&& data, const RequestParser& parser)
+    : _connection_id(data.connection_id()), _sequence(data.sequence()) {
+  // The header views the bytes that the body slice keeps alive.
+  auto bytes = Buffer::own(std::move(data));
+  _header = RequestHeader(parser, bytes.to_string_view());
+  _body = bytes.slice(parser.header_size());
+}
+
+Buffer Request::retain_body() const {
+  if (_body.shared() || _body.size() == 0) {
+    return _body;
+  }
+  return Buffer::own(std::string(body()));
 }
 
 } // namespace message
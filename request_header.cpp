@@ -1,43 +1,45 @@
 #include "include/request_header.hpp"
+#include "include/request_parser.hpp"
 
 namespace web_server {
 namespace message {
 
-int RequestHeader::parse(const DataView& data) {
-  int start = 0;
-  int ret = 0;
-  std::string_view line;
-
-  std::string_view string_data(reinterpret_cast<const char*>(data.data()), data.size());
-
-  ret = web_server::utils::get_line(string_data, line, &start);
-  std::vector<std::string_view> words;
-  web_server::utils::split_line(line, words);
-  parse_method(words[0]);
-  _path = std::string(words[1]);
-  _version = std::string(words[2]);
+RequestHeader::RequestHeader(const RequestParser& parser, std::string_view bytes)
+    : _method(parser.method()) {
+  auto rebase = [from = parser.data(), bytes](std::string_view token) {
+    return bytes.substr(static_cast<std::size_t>(token.data() - from.data()), token.size());
+  };
+  _path = rebase(parser.target());
+  _version = rebase(parser.version());
+  for (std::size_t i = 0; i < parser.field_count(); ++i) {
+    auto field = parser.field(i);
+    _headers.add(rebase(field.name), rebase(field.value));
+  }
+}
 
-  while ((ret = web_server::utils::get_line(string_data, line, &start)) != -1) {
-    std::string_view key, value;
-    web_server::utils::split_head(line, key, value);
-    _headers.emplace(std::string(key), std::string(value));
+int RequestHeader::parse(const DataView& data) {
+  RequestParser parser{};
+  std::string_view bytes{reinterpret_cast<const char*>(data.data()), data.size()};
+  if (parser.parse(bytes) != RequestParser::Status::complete) {
+    return 0;
   }
 
-  return start;
+  *this = RequestHeader(parser, bytes);
+  return static_cast<int>(parser.header_size());
 }
 
 std::size_t RequestHeader::to_bytes(std::string& bytes) const {
-  bytes += method_to_string();
+  bytes += method_name(_method);
   bytes += " ";
   bytes += _path;
   bytes += " ";
   bytes += _version;
   bytes += "\r\n";
 
-  for (const auto& [key, value] : _headers) {
-    bytes += key;
+  for (const auto& field : _headers) {
+    bytes += field.name();
     bytes += ": ";
-    bytes += value;
+    bytes += field.value;
     bytes += "\r\n";
   }
 
@@ -46,66 +48,5 @@ std::size_t RequestHeader::to_bytes(std::string& bytes) const {
   return bytes.size();
 }
 
-void RequestHeader::parse_method(std::string_view method) {
-  if (method == "GET") {
-    _method = Method::GET;
-  } else if (method == "POST") {
-    _method = Method::POST;
-  } else if (method == "PUT") {
-    _method = Method::PUT;
-  } else if (method == "DELETE") {
-    _method = Method::DELETE;
-  } else if (method == "HEAD") {
-    _method = Method::HEAD;
-  } else if (method == "OPTIONS") {
-    _method = Method::OPTIONS;
-  } else if (method == "TRACE") {
-    _method = Method::TRACE;
-  } else if (method == "CONNECT") {
-    _method = Method::CONNECT;
-  } else if (method == "PATCH") {
-    _method = Method::PATCH;
-  } else {
-    throw std::runtime_error("Unknown method");
-  }
-}
-
-[[nodiscard]] std::string RequestHeader::method_to_string() const {
-  std::string ret;
-  switch (_method) {
-  case Method::GET:
-    ret = "GET";
-    break;
-  case Method::POST:
-    ret = "POST";
-    break;
-  case Method::PUT:
-    ret = "PUT";
-    break;
-  case Method::DELETE:
-    ret = "DELETE";
-    break;
-  case Method::HEAD:
-    ret = "HEAD";
-    break;
-  case Method::OPTIONS:
-    ret = "OPTIONS";
-    break;
-  case Method::TRACE:
-    ret = "TRACE";
-    break;
-  case Method::CONNECT:
-    ret = "CONNECT";
-    break;
-  case Method::PATCH:
-    ret = "PATCH";
-    break;
-  default:
-    throw std::runtime_error("Unknown method");
-  }
-
-  return ret;
-}
-
 } // namespace message
 } // namespace web_server
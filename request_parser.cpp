@@ -0,0 +1,241 @@
+#include "include/request_parser.hpp"
+#include "include/char_scan.hpp"
+#include "include/utils.hpp"
+
+#include <cctype>
+
+namespace web_server {
+namespace message {
+
+namespace {
+
+using utils::is;
+using utils::TOKEN;
+
+} // namespace
+
+void RequestParser::reset() {
+  _data = {};
+  _state = State::method;
+  _status = Status::incomplete;
+  _error = Error::none;
+  _position = 0;
+  _line_start = 0;
+  _token_start = 0;
+  _field_count = 0;
+}
+
+int RequestParser::error_status_code() const {
+  switch (_error) {
+  case Error::none:
+    return 0;
+  case Error::bad_request:
+    return 400;
+  case Error::uri_too_long:
+    return 414;
+  case Error::header_fields_too_large:
+    return 431;
+  case Error::not_implemented:
+    return 501;
+  case Error::version_not_supported:
+    return 505;
+  }
+  return 400;
+}
+
+std::optional<std::string_view> RequestParser::find(std::string_view name) const {
+  for (std::size_t i = 0; i < _field_count; ++i) {
+    if (utils::equals_ignore_case(view(_fields[i].name), name)) {
+      return view(_fields[i].value);
+    }
+  }
+  return std::nullopt;
+}
+
+RequestParser::Status RequestParser::fail(Error error) {
+  _status = Status::error;
+  _error = error;
+  return _status;
+}
+
+RequestParser::Status RequestParser::finish_request_line() {
+  auto method = parse_method(view(_method_token));
+  if (!method) {
+    return fail(Error::not_implemented);
+  }
+  _method = *method;
+
+  auto version = view(_version);
+  if (version.size() != 8 || !version.starts_with("HTTP/") || version[6] != '.' ||
+      !std::isdigit(static_cast<unsigned char>(version[5])) ||
+      !std::isdigit(static_cast<unsigned char>(version[7]))) {
+    return fail(Error::bad_request);
+  }
+  if (version[5] != '1') {
+    return fail(Error::version_not_supported);
+  }
+  return _status;
+}
+
+RequestParser::Status RequestParser::parse(std::string_view data) {
+  _data = data;
+  if (_status != Status::incomplete) {
+    return _status;
+  }
+
+  auto size = data.size();
+  auto i = _position;
+  auto token = [this](std::size_t end) {
+    return Token{static_cast<std::uint32_t>(_token_start),
+                 static_cast<std::uint32_t>(end - _token_start)};
+  };
+  while (i < size && _state != State::done) {
+    switch (_state) {
+    case State::method:
+      if (i == _line_start && (data[i] == '\r' || data[i] == '\n')) {
+        // Empty lines before the request line are ignored.
+        _line_start = _token_start = ++i;
+        break;
+      }
+      i = utils::skip_token(data, i);
+      if (i == size) {
+        break;
+      }
+      if (data[i] != ' ' || i == _token_start) {
+        return fail(Error::bad_request);
+      }
+      _method_token = token(i);
+      _token_start = ++i;
+      _state = State::target;
+      break;
+    case State::target:
+      i = utils::skip_target(data, i);
+      if (i == size) {
+        break;
+      }
+      if (data[i] != ' ' || i == _token_start) {
+        return fail(Error::bad_request);
+      }
+      _target = token(i);
+      _token_start = ++i;
+      _state = State::version;
+      break;
+    case State::version:
+      i = utils::skip_target(data, i);
+      if (i == size) {
+        break;
+      }
+      if (i - _line_start > _max_request_line) {
+        return fail(Error::uri_too_long);
+      }
+      if (data[i] != '\r') {
+        return fail(Error::bad_request);
+      }
+      _version = token(i);
+      ++i;
+      _state = State::request_line_lf;
+      break;
+    case State::request_line_lf:
+      if (data[i] != '\n') {
+        return fail(Error::bad_request);
+      }
+      ++i;
+      if (finish_request_line() == Status::error) {
+        return _status;
+      }
+      _state = State::field_start;
+      break;
+    case State::field_start:
+      if (data[i] == '\r') {
+        ++i;
+        _state = State::header_end_lf;
+        break;
+      }
+      // A leading space would be an obsolete line folding.
+      if (!is(data[i], TOKEN)) {
+        return fail(Error::bad_request);
+      }
+      if (_field_count == MAX_FIELDS) {
+        return fail(Error::header_fields_too_large);
+      }
+      _token_start = i;
+      _state = State::field_name;
+      break;
+    case State::field_name:
+      i = utils::skip_token(data, i);
+      if (i == size) {
+        break;
+      }
+      // No whitespace is allowed before the colon.
+      if (data[i] != ':') {
+        return fail(Error::bad_request);
+      }
+      _fields[_field_count].name = token(i);
+      ++i;
+      _state = State::field_value_start;
+      break;
+    case State::field_value_start:
+      while (i < size && (data[i] == ' ' || data[i] == '\t')) {
+        ++i;
+      }
+      if (i == size) {
+        break;
+      }
+      _token_start = i;
+      _state = State::field_value;
+      break;
+    case State::field_value: {
+      i = utils::skip_value(data, i);
+      if (i == size) {
+        break;
+      }
+      if (data[i] != '\r') {
+        return fail(Error::bad_request);
+      }
+      auto end = i;
+      while (end > _token_start && (data[end - 1] == ' ' || data[end - 1] == '\t')) {
+        --end;
+      }
+      _fields[_field_count].value = token(end);
+      ++i;
+      _state = State::field_lf;
+      break;
+    }
+    case State::field_lf:
+      if (data[i] != '\n') {
+        return fail(Error::bad_request);
+      }
+      ++i;
+      ++_field_count;
+      _state = State::field_start;
+      break;
+    case State::header_end_lf:
+      if (data[i] != '\n') {
+        return fail(Error::bad_request);
+      }
+      ++i;
+      _state = State::done;
+      break;
+    case State::done:
+      break;
+    }
+  }
+  _position = i;
+
+  auto in_request_line = _state == State::method || _state == State::target ||
+                         _state == State::version;
+  if (in_request_line && _position - _line_start > _max_request_line) {
+    return fail(Error::uri_too_long);
+  }
+  if (_state == State::done) {
+    return _position > _max_header_size ? fail(Error::header_fields_too_large)
+                                        : (_status = Status::complete);
+  }
+  if (_position >= _max_header_size) {
+    return fail(Error::header_fields_too_large);
+  }
+  return _status;
+}
+
+} // namespace message
+} // namespace web_server
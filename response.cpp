@@ -7,7 +7,20 @@ Response::Response(const DataView& data) {
   int start = _header.parse(data);
   auto sub_data = data.subdata(start, std::string::npos);
 
-  _body = std::string((char*)sub_data.data(), sub_data.size());
+  _body = Buffer(nullptr, sub_data.data(), sub_data.size());
+}
+
+Response::Response(Data&& data) {
+  int start = _header.parse(data);
+
+  _body = Buffer::own(std::move(data)).slice(start);
+}
+
+Buffer Response::retain_body() const {
+  if (_body.shared() || _body.size() == 0) {
+    return _body;
+  }
+  return Buffer::own(std::string(body()));
 }
 
 } // namespace message
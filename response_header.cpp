@@ -1,5 +1,8 @@
 #include "include/response_header.hpp"
 
+#include <charconv>
+#include <cstring>
+
 namespace web_server {
 namespace message {
 
@@ -20,31 +23,65 @@ int ResponseHeader::parse(const DataView& data) {
   while ((ret = web_server::utils::get_line(string_data, line, &start)) != -1) {
     std::string_view key, value;
     web_server::utils::split_head(line, key, value);
-    _headers.emplace(std::string(key), std::string(value));
+    _headers.add(key, value);
   }
 
   return start;
 }
 
-std::size_t ResponseHeader::to_bytes(std::string& bytes) const {
-  bytes += _version;
-  bytes += " ";
-  bytes += std::to_string(_status_code);
-  bytes += " ";
-  bytes += _status_message;
-  bytes += "\r\n";
-
-  for (const auto& [key, value] : _headers) {
-    bytes += key;
-    bytes += ": ";
-    bytes += value;
-    bytes += "\r\n";
+std::size_t ResponseHeader::size() const {
+  auto line = prebuilt_status_line();
+  std::size_t size = line.size();
+  if (line.empty()) {
+    char code[16];
+    auto code_end = std::to_chars(code, code + sizeof(code), _status_code).ptr;
+    size = _version.size() + 1 + (code_end - code) + 1 + _status_message.size() + 2;
+  }
+  for (const auto& field : _headers) {
+    size += field.name().size() + 2 + field.value.size() + 2;
   }
+  return size + 2;
+}
 
-  bytes += "\r\n";
+std::size_t ResponseHeader::write(char* buffer) const {
+  auto out = buffer;
+  auto put = [&out](std::string_view part) {
+    std::memcpy(out, part.data(), part.size());
+    out += part.size();
+  };
+  if (auto line = prebuilt_status_line(); !line.empty()) {
+    put(line);
+  } else {
+    put(_version);
+    put(" ");
+    out = std::to_chars(out, out + 16, _status_code).ptr;
+    put(" ");
+    put(_status_message);
+    put("\r\n");
+  }
+  for (const auto& field : _headers) {
+    put(field.name());
+    put(": ");
+    put(field.value);
+    put("\r\n");
+  }
+  put("\r\n");
+  return out - buffer;
+}
 
+std::size_t ResponseHeader::to_bytes(std::string& bytes) const {
+  auto offset = bytes.size();
+  bytes.resize(offset + size());
+  write(bytes.data() + offset);
   return bytes.size();
 }
 
+std::string_view ResponseHeader::prebuilt_status_line() const {
+  if (_version != "HTTP/1.1" || _status_message != reason_phrase(_status_code)) {
+    return {};
+  }
+  return status_line(_status_code);
+}
+
 } // namespace message
 } // namespace web_server
@@ -0,0 +1,116 @@
+#include "include/socket_options.hpp"
+#include "include/logger.hpp"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+namespace web_server {
+namespace reactor {
+
+namespace {
+
+using NoDelay = boost::asio::ip::tcp::no_delay;
+using ReceiveBuffer = boost::asio::socket_base::receive_buffer_size;
+using SendBuffer = boost::asio::socket_base::send_buffer_size;
+#ifdef TCP_DEFER_ACCEPT
+using DeferAccept = boost::asio::detail::socket_option::integer<IPPROTO_TCP, TCP_DEFER_ACCEPT>;
+#endif
+#ifdef TCP_FASTOPEN
+using FastOpen = boost::asio::detail::socket_option::integer<IPPROTO_TCP, TCP_FASTOPEN>;
+#endif
+#ifdef TCP_QUICKACK
+using QuickAck = boost::asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_QUICKACK>;
+#endif
+#ifdef SO_BUSY_POLL
+using BusyPoll = boost::asio::detail::socket_option::integer<SOL_SOCKET, SO_BUSY_POLL>;
+#endif
+
+template <typename Socket, typename Option>
+void set_listener_option(Socket& socket, const Option& option, const std::string& name) {
+  boost::system::error_code ec;
+  socket.set_option(option, ec);
+  if (ec) {
+    utils::Logger::logger().warning("SocketOptions::Failed to set " + name + ": " +
+                                    ec.message() + ".");
+  }
+}
+
+template <typename Option>
+std::string get_option(boost::asio::ip::tcp::acceptor& acceptor) {
+  Option option{};
+  boost::system::error_code ec;
+  acceptor.get_option(option, ec);
+  if (ec) {
+    return "?";
+  }
+  return std::to_string(static_cast<int>(option.value()));
+}
+
+} // namespace
+
+void SocketOptions::apply(boost::asio::ip::tcp::acceptor& acceptor) const {
+  // Accepted sockets inherit these from the listener.
+  set_listener_option(acceptor, NoDelay(no_delay), "TCP_NODELAY");
+  if (receive_buffer > 0) {
+    // Before listen, so the window scale offered in the handshake fits it.
+    set_listener_option(acceptor, ReceiveBuffer(receive_buffer), "SO_RCVBUF");
+  }
+  if (send_buffer > 0) {
+    set_listener_option(acceptor, SendBuffer(send_buffer), "SO_SNDBUF");
+  }
+  if (defer_accept > 0) {
+#ifdef TCP_DEFER_ACCEPT
+    set_listener_option(acceptor, DeferAccept(defer_accept), "TCP_DEFER_ACCEPT");
+#else
+    utils::Logger::logger().warning("SocketOptions::TCP_DEFER_ACCEPT is not supported.");
+#endif
+  }
+  if (fast_open_queue > 0) {
+#ifdef TCP_FASTOPEN
+    set_listener_option(acceptor, FastOpen(fast_open_queue), "TCP_FASTOPEN");
+#else
+    utils::Logger::logger().warning("SocketOptions::TCP_FASTOPEN is not supported.");
+#endif
+  }
+  if (busy_poll > 0) {
+#ifdef SO_BUSY_POLL
+    set_listener_option(acceptor, BusyPoll(busy_poll), "SO_BUSY_POLL");
+#else
+    utils::Logger::logger().warning("SocketOptions::SO_BUSY_POLL is not supported.");
+#endif
+  }
+}
+
+void SocketOptions::apply(boost::asio::ip::tcp::socket& socket) const {
+  boost::system::error_code ec;
+  if (no_delay) {
+    socket.set_option(NoDelay(true), ec);
+  }
+#ifdef TCP_QUICKACK
+  if (quick_ack) {
+    socket.set_option(QuickAck(true), ec);
+  }
+#endif
+}
+
+std::string SocketOptions::describe(boost::asio::ip::tcp::acceptor& acceptor) const {
+  std::string description{"TCP_NODELAY=" + get_option<NoDelay>(acceptor)};
+  description += " SO_RCVBUF=" + get_option<ReceiveBuffer>(acceptor);
+  description += " SO_SNDBUF=" + get_option<SendBuffer>(acceptor);
+#ifdef TCP_DEFER_ACCEPT
+  description += " TCP_DEFER_ACCEPT=" + get_option<DeferAccept>(acceptor);
+#endif
+#ifdef TCP_FASTOPEN
+  description += " TCP_FASTOPEN=" + get_option<FastOpen>(acceptor);
+#endif
+#ifdef SO_BUSY_POLL
+  description += " SO_BUSY_POLL=" + get_option<BusyPoll>(acceptor);
+#endif
+#ifdef TCP_QUICKACK
+  description += std::string(" TCP_QUICKACK=") + (quick_ack ? "1" : "0");
+#endif
+  return description;
+}
+
+} // namespace reactor
+} // namespace web_server
@@ -1,44 +1,251 @@
 #include "include/static_server.hpp"
+#include "include/status_code.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <random>
 
 namespace web_server {
-std::uint32_t StaticServer::file_size(std::fstream& file) {
-  file.seekg(0, std::ios::end);
-  std::size_t content_size = file.tellg();
-  file.seekg(0, std::ios::beg);
-  return content_size;
+std::filesystem::path StaticServer::canonical_root(const std::filesystem::path& root_path) {
+  std::error_code ec;
+  auto canonical = std::filesystem::canonical(root_path, ec);
+  return ec ? root_path : canonical;
+}
+
+std::string StaticServer::generate_boundary() {
+  std::random_device device{};
+  std::mt19937_64 generator{device()};
+  static constexpr char digits[] = "0123456789abcdef";
+  std::string boundary{"byteranges_"};
+  for (int i = 0; i < 24; ++i) {
+    boundary += digits[generator() % 16];
+  }
+  return boundary;
 }
 
-std::uint32_t StaticServer::generate_header(std::stringstream& header_ss,
-                                            const std::string& response_line,
-                                            std::uint32_t content_size) {
-  header_ss << response_line << "\r\n"
-            << "Content-Length: " << content_size << "\r\n"
-            << "Content-Type: text/html\r\n"
-            << "\r\n";
+std::string StaticServer::generate_header(std::uint32_t status_code, std::uint64_t content_size,
+                                          std::string_view content_type,
+                                          std::string_view fields) {
+  constexpr std::string_view length_name{"Content-Length: "};
+  constexpr std::string_view type_name{"\r\nContent-Type: "};
+  auto line = message::status_line(status_code);
+  char length[20];
+  auto length_end = std::to_chars(length, length + sizeof(length), content_size).ptr;
 
-  header_ss.seekg(0, std::ios::end);
-  std::size_t header_size = header_ss.tellg();
-  header_ss.seekg(0, std::ios::beg);
+  std::string header{};
+  header.reserve(line.size() + length_name.size() + (length_end - length) + type_name.size() +
+                 content_type.size() + 2 + fields.size() + 2);
+  header += line;
+  header += length_name;
+  header.append(length, length_end);
+  header += type_name;
+  header += content_type;
+  header += "\r\n";
+  header += fields;
+  header += "\r\n";
+  return header;
+}
 
-  return header_size;
+message::Payload StaticServer::file_response(std::shared_ptr<const message::File> file,
+                                             std::uint32_t connection_id,
+                                             std::uint32_t status_code, std::string_view fields,
+                                             std::string_view content_type) {
+  message::Payload payload{connection_id};
+  payload.append(
+      message::Buffer::own(generate_header(status_code, file->size(), content_type, fields)));
+  payload.append(message::FileRegion(file, 0, file->size()));
+  return payload;
 }
 
-message::Data StaticServer::read_file(std::fstream& file, std::uint32_t content_size,
-                                      std::uint32_t connection_id, std::stringstream& header_ss,
-                                      std::uint32_t header_size) {
-  message::Data data(header_size + content_size);
+message::Payload StaticServer::range_response(std::shared_ptr<const message::File> file,
+                                              std::uint32_t connection_id,
+                                              std::string_view range,
+                                              const std::string& fields,
+                                              std::string_view content_type) {
+  auto size = file->size();
+  auto content_range = [size](const message::ByteRange& byte_range) {
+    return "bytes " + std::to_string(byte_range.first) + "-" + std::to_string(byte_range.last) +
+           "/" + std::to_string(size);
+  };
 
-  data.append(header_ss, header_size);
-  data.append(file, content_size);
+  std::vector<message::ByteRange> ranges{};
+  switch (message::parse_byte_ranges(range, size, ranges)) {
+  case message::RangeStatus::ignored:
+    return file_response(file, connection_id, 200, fields, content_type);
+  case message::RangeStatus::unsatisfiable: {
+    message::Payload payload{connection_id};
+    payload.append(message::Buffer::own(generate_header(
+        416, assets::RANGE_NOT_SATISFIABLE_BODY.size(),
+        "text/html", fields + "Content-Range: bytes */" + std::to_string(size) + "\r\n")));
+    payload.append(message::Buffer::view(assets::RANGE_NOT_SATISFIABLE_BODY));
+    return payload;
+  }
+  case message::RangeStatus::satisfiable:
+    break;
+  }
 
-  data.set_connection_id(connection_id);
+  message::Payload payload{connection_id};
+  if (ranges.size() == 1) {
+    payload.append(message::Buffer::own(
+        generate_header(206, ranges[0].length(), content_type,
+                        fields + "Content-Range: " + content_range(ranges[0]) + "\r\n")));
+    payload.append(message::FileRegion(file, ranges[0].first, ranges[0].length()));
+    return payload;
+  }
+
+  // Every part is a header from memory followed by its file region.
+  std::vector<std::string> part_headers{};
+  std::uint64_t content_size = 0;
+  for (const auto& byte_range : ranges) {
+    part_headers.push_back("\r\n--" + _boundary + "\r\nContent-Type: " +
+                           std::string(content_type) + "\r\nContent-Range: " +
+                           content_range(byte_range) + "\r\n\r\n");
+    content_size += part_headers.back().size() + byte_range.length();
+  }
+  std::string closing{"\r\n--" + _boundary + "--\r\n"};
+  content_size += closing.size();
+
+  payload.append(message::Buffer::own(
+      generate_header(206, content_size,
+                      "multipart/byteranges; boundary=" + _boundary, fields)));
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    payload.append(message::Buffer::own(std::move(part_headers[i])));
+    payload.append(message::FileRegion(file, ranges[i].first, ranges[i].length()));
+  }
+  payload.append(message::Buffer::own(std::move(closing)));
+  return payload;
+}
+
+std::optional<message::Payload>
+StaticServer::cached_response(message::FileCache::Entry file, std::uint32_t connection_id,
+                              const message::RequestHeader& header) {
+  if (header.method() != message::Method::GET && header.method() != message::Method::HEAD) {
+    return std::nullopt;
+  }
+  if (not_modified(header, file->entity_tag, file->metadata.modified)) {
+    return header_response(connection_id, 304, file->fields);
+  }
+  if (header.method() == message::Method::GET && header.contain(message::HeaderId::range)) {
+    return std::nullopt;
+  }
+  // Both segments point into the entry and keep it alive until sent.
+  message::Payload payload{connection_id};
+  payload.append(message::Buffer(file, reinterpret_cast<const std::uint8_t*>(file->header.data()),
+                                 file->header.size()));
+  if (header.method() == message::Method::GET) {
+    payload.append(message::Buffer(file, reinterpret_cast<const std::uint8_t*>(file->body.data()),
+                                   file->body.size()));
+  }
+  return payload;
+}
+
+message::Payload StaticServer::header_response(std::uint32_t connection_id,
+                                               std::uint32_t status_code,
+                                               std::string_view fields) {
+  auto line = message::status_line(status_code);
+  std::string header{};
+  header.reserve(line.size() + fields.size() + 2);
+  header += line;
+  header += fields;
+  header += "\r\n";
+  message::Payload payload{connection_id};
+  payload.append(message::Buffer::own(std::move(header)));
+  return payload;
+}
+
+void StaticServer::select_sibling(Representation& file,
+                                  const message::AcceptedCodings& accepted) {
+  // Brotli compresses text better than gzip, so it is preferred.
+  for (std::string_view coding : {"br", "gzip"}) {
+    if (!(coding == "br" ? accepted.br : accepted.gzip)) {
+      continue;
+    }
+    auto sibling = file.path;
+    sibling += message::coding_extension(coding);
+    if (auto metadata = message::FileMetadata::stat(sibling); metadata && metadata->is_regular) {
+      file.path = std::move(sibling);
+      file.metadata = *metadata;
+      file.coding = coding;
+      return;
+    }
+  }
+}
+
+std::string StaticServer::validator_fields(const message::FileMetadata& metadata,
+                                           const std::string& entity_tag, bool vary) {
+  std::string fields{"Accept-Ranges: bytes\r\n"
+                     "Last-Modified: "};
+  fields += utils::http_date(metadata.modified);
+  fields += "\r\nETag: ";
+  fields += entity_tag;
+  fields += "\r\n";
+  if (vary) {
+    fields += "Vary: Accept-Encoding\r\n";
+  }
+  return fields;
+}
 
-  return data;
+std::string StaticServer::entity_tag(const message::FileMetadata& metadata,
+                                     std::string_view coding) {
+  char tag[64];
+  std::snprintf(tag, sizeof(tag), "\"%llx-%llx-%llx%08x%s%.*s\"",
+                static_cast<unsigned long long>(metadata.inode),
+                static_cast<unsigned long long>(metadata.size),
+                static_cast<unsigned long long>(metadata.modified), metadata.modified_nsec,
+                coding.empty() ? "" : "-", static_cast<int>(coding.size()), coding.data());
+  bool recent = std::time(nullptr) - metadata.modified < 1;
+  return recent ? "W/" + std::string(tag) : std::string(tag);
 }
 
-message::Data StaticServer::implement_handle_request(std::uint32_t connection_id,
-                                                     const message::Data& data) {
-  message::Request request(data);
+bool StaticServer::not_modified(const message::RequestHeader& header,
+                                const std::string& entity_tag, std::time_t modified) {
+  if (header.contain(message::HeaderId::if_none_match)) {
+    // Weak comparison: W/ prefixes do not matter.
+    auto opaque = [](std::string_view tag) {
+      auto first = tag.find_first_not_of(" \t");
+      if (first == std::string_view::npos) {
+        return std::string_view{};
+      }
+      tag = tag.substr(first, tag.find_last_not_of(" \t") - first + 1);
+      return tag.starts_with("W/") ? tag.substr(2) : tag;
+    };
+    auto current = opaque(entity_tag);
+    std::string_view tags{header.get(message::HeaderId::if_none_match)};
+    while (true) {
+      auto comma = tags.find(',');
+      auto tag = opaque(tags.substr(0, comma));
+      if (tag == "*" || tag == current) {
+        return true;
+      }
+      if (comma == std::string_view::npos) {
+        return false;
+      }
+      tags.remove_prefix(comma + 1);
+    }
+  }
+  std::time_t since = 0;
+  return header.contain(message::HeaderId::if_modified_since) &&
+         utils::parse_http_date(header.get(message::HeaderId::if_modified_since), since) &&
+         modified <= since;
+}
+
+bool StaticServer::if_range_matches(const message::RequestHeader& header,
+                                    const message::FileMetadata& metadata) {
+  if (!header.contain(message::HeaderId::if_range)) {
+    return true;
+  }
+  // Strong comparison: a weak entity tag never matches.
+  auto validator = header.get(message::HeaderId::if_range);
+  if (validator.starts_with("\"")) {
+    auto current = entity_tag(metadata);
+    return !current.starts_with("W/") && validator == current;
+  }
+  return validator == utils::http_date(metadata.modified);
+}
+
+message::Payload StaticServer::implement_handle_request(std::uint32_t connection_id,
+                                                        const message::Request& request) {
   std::string_view path_view(request.header().path());
 #ifdef DEBUG
   utils::Logger::logger().debug("StaticServer::Request path: " + std::string(path_view));
@@ -50,35 +257,136 @@ message::Data StaticServer::implement_handle_request(std::uint32_t connection_id
   utils::Logger::logger().debug("StaticServer::File path: " + file_path.string());
 #endif
 
+  const auto& header = request.header();
+  message::AcceptedCodings accepted{};
+  if (header.contain(message::HeaderId::accept_encoding)) {
+    accepted = message::AcceptedCodings::parse(header.get(message::HeaderId::accept_encoding));
+  }
+  // A directory is cached under its own path, not its index file.
+  auto key = file_path;
+  auto cached = _cache->find(key, accepted.name());
+  if (!cached && accepted.any()) {
+    // Files that are not compressed have only the identity variant.
+    cached = _cache->find(key);
+    cached = cached && !cached->vary ? cached : nullptr;
+  }
+  if (cached) {
+    if (auto response = cached_response(cached, connection_id, header)) {
+      return std::move(*response);
+    }
+  }
+
   if (std::filesystem::exists(file_path) && std::filesystem::is_directory(file_path)) {
     file_path.append("index.html");
   }
 
-  if (std::filesystem::exists(file_path)) {
-    std::fstream file(file_path, std::ios::in);
-    std::stringstream header_ss;
+  auto metadata = message::FileMetadata::stat(file_path);
+  if (metadata && !metadata->is_directory) {
+    auto content_type = message::mime_type(file_path);
+    Representation file{.path = file_path,
+                        .metadata = *metadata,
+                        .content_type = content_type,
+                        .coding = {},
+                        .vary = message::is_compressible(content_type)};
+    if (!file.vary) {
+      accepted = {};
+    }
+    // Ranges are served from the file itself.
+    auto ranged =
+        header.method() == message::Method::GET && header.contain(message::HeaderId::range);
+    if (!ranged) {
+      select_sibling(file, accepted);
+    }
+    // Without a sibling, the file is compressed once and cached.
+    auto compress = !ranged && file.coding.empty() && accepted.gzip && _cache->enabled() &&
+                    file.metadata.size >= message::MIN_COMPRESS_SIZE &&
+                    file.metadata.size <= _cache->options().max_file_size;
+
+    auto cacheable = header.method() == message::Method::GET ||
+                     header.method() == message::Method::HEAD;
+    auto prepare = [this, &file, compress](message::CachedFile& cached) {
+      auto coding = file.coding;
+      std::string compressed{};
+      if (compress && message::gzip(cached.body, compressed)) {
+        cached.body = std::move(compressed);
+        coding = "gzip";
+      }
+      cached.entity_tag = entity_tag(cached.metadata, coding);
+      cached.vary = file.vary;
+      cached.fields = validator_fields(cached.metadata, cached.entity_tag, cached.vary);
+      cached.header = generate_header(
+          200, cached.body.size(), file.content_type,
+          coding.empty() ? cached.fields
+                         : cached.fields + "Content-Encoding: " + std::string(coding) + "\r\n");
+    };
+    if (compress && cacheable) {
+      // Only the loaded entry knows whether the body is compressed, so it
+      // answers conditional requests with its own validator.
+      if (auto loaded = _cache->load(key, file.path, prepare, accepted.name())) {
+        return std::move(*cached_response(loaded, connection_id, header));
+      }
+      // Not cached, e.g. modified within the last second: the identity file
+      // is sent, validated by its own tag.
+    }
 
-    auto content_size = file_size(file);
-    auto header_size = generate_header(header_ss, "HTTP/1.1 200 OK", content_size);
+    auto tag = entity_tag(file.metadata, file.coding);
+    if (cacheable && not_modified(header, tag, file.metadata.modified)) {
+      return header_response(connection_id, 304,
+                             validator_fields(file.metadata, tag, file.vary));
+    }
 
-    return read_file(file, content_size, connection_id, header_ss, header_size);
-  } else {
-    std::filesystem::path error_file_path(_root_path);
-    error_file_path.append("404.html");
-    if (_custom_error_page && std::filesystem::exists(error_file_path)) {
-      std::fstream file(error_file_path, std::ios::in);
-      std::stringstream header_ss;
-
-      auto content_size = file_size(file);
-      auto header_size = generate_header(header_ss, "HTTP/1.1 404 Not Found", content_size);
-
-      return read_file(file, content_size, connection_id, header_ss, header_size);
-    } else {
-      message::Data data(reinterpret_cast<const std::uint8_t*>(assets::NOT_FOUND_RESPONSE.data()),
-                         assets::NOT_FOUND_RESPONSE.size(), connection_id);
-      return data;
+    if (!ranged && !compress && file.metadata.size <= _cache->options().max_file_size &&
+        header.method() == message::Method::GET) {
+      if (auto loaded = _cache->load(key, file.path, prepare, accepted.name())) {
+        return std::move(*cached_response(loaded, connection_id, header));
+      }
+    }
+
+    auto encoding = file.coding.empty()
+                        ? std::string{}
+                        : "Content-Encoding: " + std::string(file.coding) + "\r\n";
+    if (header.method() == message::Method::HEAD) {
+      // Answered from metadata alone; the file is not opened.
+      return header_response(connection_id, 200,
+                             "Content-Length: " + std::to_string(file.metadata.size) +
+                                 "\r\nContent-Type: " + std::string(file.content_type) +
+                                 "\r\n" + encoding +
+                                 validator_fields(file.metadata, tag, file.vary));
     }
+
+    if (auto opened = message::File::open(file.path)) {
+      // Describe the file that is sent, even if it changed since the stat.
+      auto fields = validator_fields(opened->metadata(),
+                                     entity_tag(opened->metadata(), file.coding), file.vary);
+      if (ranged && if_range_matches(header, opened->metadata())) {
+        return range_response(opened, connection_id, header.get(message::HeaderId::range), fields,
+                              file.content_type);
+      }
+      return file_response(opened, connection_id, 200, fields + encoding,
+                           file.content_type);
+    }
+  }
+
+  std::filesystem::path error_file_path(_root_path);
+  error_file_path.append("404.html");
+  std::shared_ptr<const message::File> file{};
+  if (_custom_error_page && (file = message::File::open(error_file_path))) {
+    if (header.method() == message::Method::HEAD) {
+      return header_response(connection_id, 404,
+                             "Content-Length: " + std::to_string(file->size()) +
+                                 "\r\n"
+                                 "Content-Type: text/html\r\n");
+    }
+    return file_response(file, connection_id, 404);
+  }
+  message::Payload payload{connection_id};
+  if (header.method() == message::Method::HEAD) {
+    std::string_view response{assets::NOT_FOUND_RESPONSE};
+    payload.append(message::Buffer::view(response.substr(0, response.find("\r\n\r\n") + 4)));
+  } else {
+    payload.append(message::Buffer::view(assets::NOT_FOUND_RESPONSE));
   }
+  return payload;
 }
 
 } // namespace web_server
@@ -0,0 +1,127 @@
+#include "../include/body_framer.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using web_server::message::BodyFramer;
+using web_server::message::RequestParser;
+
+namespace {
+
+// Starts framer on a request header parsed the way the connection does.
+bool start(BodyFramer& framer, std::string_view header) {
+  RequestParser parser{};
+  EXPECT_EQ(parser.parse(header), RequestParser::Status::complete) << header;
+  return framer.start(parser);
+}
+
+// Feeds input split into pieces of `step` bytes, as if read one at a time,
+// and collects the body. Returns the status of the last decode.
+BodyFramer::Status feed(BodyFramer& framer, const std::string& input, std::size_t step,
+                        std::string& body, std::size_t& consumed) {
+  auto status = BodyFramer::Status::incomplete;
+  consumed = 0;
+  std::string pending{};
+  for (std::size_t i = 0; i < input.size() && status == BodyFramer::Status::incomplete;
+       i += step) {
+    pending += input.substr(i, step);
+    std::vector<std::string_view> pieces{};
+    std::size_t used = 0;
+    status = framer.decode(pending, used, pieces);
+    for (auto piece : pieces) {
+      body += piece;
+    }
+    consumed += used;
+    pending.erase(0, used);
+  }
+  return status;
+}
+
+} // namespace
+
+TEST(BodyFramerTest, NoBody) {
+  BodyFramer framer{};
+  EXPECT_TRUE(start(framer, "GET / HTTP/1.1\r\nHost: a\r\n\r\n"));
+  EXPECT_EQ(framer.framing(), BodyFramer::Framing::none);
+  EXPECT_TRUE(framer.done());
+
+  EXPECT_TRUE(start(framer, "POST / HTTP/1.1\r\nContent-Length: 0\r\n\r\n"));
+  EXPECT_EQ(framer.framing(), BodyFramer::Framing::none);
+}
+
+TEST(BodyFramerTest, ContentLength) {
+  BodyFramer framer{};
+  ASSERT_TRUE(start(framer, "POST / HTTP/1.1\r\ncontent-length:  11 \r\n\r\n"));
+  EXPECT_EQ(framer.framing(), BodyFramer::Framing::length);
+  EXPECT_EQ(framer.content_length(), 11);
+
+  std::string body{};
+  std::size_t consumed = 0;
+  EXPECT_EQ(feed(framer, "Hello WorldGET / HTTP/1.1\r\n\r\n", 3, body, consumed),
+            BodyFramer::Status::complete);
+  EXPECT_EQ(body, "Hello World");
+  EXPECT_EQ(consumed, 11);
+  EXPECT_TRUE(framer.done());
+}
+
+TEST(BodyFramerTest, LargeContentLength) {
+  BodyFramer framer{};
+  ASSERT_TRUE(start(framer, "PUT / HTTP/1.1\r\nContent-Length: 10000000000\r\n\r\n"));
+  EXPECT_EQ(framer.content_length(), 10000000000ull);
+}
+
+TEST(BodyFramerTest, Chunked) {
+  std::string input = "5\r\nHello\r\n"
+                      "6;name=value\r\n World\r\n"
+                      "A\r\n0123456789\r\n"
+                      "0\r\n"
+                      "Trailer: x\r\n"
+                      "\r\n"
+                      "GET /next HTTP/1.1\r\n\r\n";
+  auto body_size = input.find("GET /next");
+  for (std::size_t step : {1, 2, 7, 1000}) {
+    BodyFramer framer{};
+    ASSERT_TRUE(start(framer, "POST / HTTP/1.1\r\nTransfer-Encoding: gzip, Chunked\r\n\r\n"));
+    EXPECT_EQ(framer.framing(), BodyFramer::Framing::chunked);
+
+    std::string body{};
+    std::size_t consumed = 0;
+    EXPECT_EQ(feed(framer, input, step, body, consumed), BodyFramer::Status::complete) << step;
+    EXPECT_EQ(body, "Hello World0123456789") << step;
+    EXPECT_EQ(consumed, body_size) << step;
+  }
+}
+
+TEST(BodyFramerTest, MalformedHeader) {
+  BodyFramer framer{};
+  EXPECT_FALSE(start(framer, "POST / HTTP/1.1\r\nContent-Length: 12a\r\n\r\n"));
+  EXPECT_FALSE(start(framer, "POST / HTTP/1.1\r\nContent-Length: \r\n\r\n"));
+  EXPECT_FALSE(start(framer, "POST / HTTP/1.1\r\nContent-Length: 99999999999999999999\r\n\r\n"));
+  EXPECT_FALSE(start(framer, "POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n"));
+  EXPECT_TRUE(start(framer, "POST / HTTP/1.1\r\nContent-Length: 2\r\nContent-Length: 2\r\n\r\n"));
+  // Ambiguous framing is what request smuggling relies on.
+  EXPECT_FALSE(start(
+      framer, "POST / HTTP/1.1\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n"));
+  EXPECT_FALSE(start(framer, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked, gzip\r\n\r\n"));
+}
+
+TEST(BodyFramerTest, MalformedChunks) {
+  for (std::string input : {"x\r\n", "5\r\nHelloXY", "5\nHello\r\n", "\r\n",
+                            "10000000000000000\r\n"}) {
+    BodyFramer framer{};
+    ASSERT_TRUE(start(framer, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"));
+    std::string body{};
+    std::size_t consumed = 0;
+    EXPECT_EQ(feed(framer, input, 1, body, consumed), BodyFramer::Status::error) << input;
+  }
+}
+
+TEST(BodyFramerTest, ChunkSizeLineTooLong) {
+  BodyFramer framer{};
+  ASSERT_TRUE(start(framer, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"));
+  std::string body{};
+  std::size_t consumed = 0;
+  EXPECT_EQ(feed(framer, "5;" + std::string(8192, 'x'), 512, body, consumed),
+            BodyFramer::Status::error);
+}
@@ -0,0 +1,71 @@
+#include "../include/byte_range.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using web_server::message::ByteRange;
+using web_server::message::parse_byte_ranges;
+using web_server::message::RangeStatus;
+
+TEST(ByteRangeTest, Single) {
+  std::vector<ByteRange> ranges{};
+  EXPECT_EQ(parse_byte_ranges("bytes=0-499", 1000, ranges), RangeStatus::satisfiable);
+  EXPECT_EQ(ranges, std::vector<ByteRange>({{0, 499}}));
+  EXPECT_EQ(ranges[0].length(), 500);
+
+  EXPECT_EQ(parse_byte_ranges("bytes=500-", 1000, ranges), RangeStatus::satisfiable);
+  EXPECT_EQ(ranges, std::vector<ByteRange>({{500, 999}}));
+
+  EXPECT_EQ(parse_byte_ranges("bytes=-200", 1000, ranges), RangeStatus::satisfiable);
+  EXPECT_EQ(ranges, std::vector<ByteRange>({{800, 999}}));
+}
+
+TEST(ByteRangeTest, Clamp) {
+  std::vector<ByteRange> ranges{};
+  EXPECT_EQ(parse_byte_ranges("bytes=900-2000", 1000, ranges), RangeStatus::satisfiable);
+  EXPECT_EQ(ranges, std::vector<ByteRange>({{900, 999}}));
+
+  EXPECT_EQ(parse_byte_ranges("bytes=-5000", 1000, ranges), RangeStatus::satisfiable);
+  EXPECT_EQ(ranges, std::vector<ByteRange>({{0, 999}}));
+}
+
+TEST(ByteRangeTest, Multiple) {
+  std::vector<ByteRange> ranges{};
+  EXPECT_EQ(parse_byte_ranges("Bytes= 500-599 , 0-99,-10", 1000, ranges),
+            RangeStatus::satisfiable);
+  EXPECT_EQ(ranges, std::vector<ByteRange>({{500, 599}, {0, 99}, {990, 999}}));
+
+  // Overlapping ranges are sorted and merged.
+  EXPECT_EQ(parse_byte_ranges("bytes=500-700,0-99,600-800,50-60", 1000, ranges),
+            RangeStatus::satisfiable);
+  EXPECT_EQ(ranges, std::vector<ByteRange>({{0, 99}, {500, 800}}));
+
+  // Unsatisfiable ranges among satisfiable ones are dropped.
+  EXPECT_EQ(parse_byte_ranges("bytes=2000-3000,0-0", 1000, ranges), RangeStatus::satisfiable);
+  EXPECT_EQ(ranges, std::vector<ByteRange>({{0, 0}}));
+}
+
+TEST(ByteRangeTest, Unsatisfiable) {
+  std::vector<ByteRange> ranges{};
+  EXPECT_EQ(parse_byte_ranges("bytes=1000-", 1000, ranges), RangeStatus::unsatisfiable);
+  EXPECT_EQ(parse_byte_ranges("bytes=-0", 1000, ranges), RangeStatus::unsatisfiable);
+  EXPECT_EQ(parse_byte_ranges("bytes=0-10", 0, ranges), RangeStatus::unsatisfiable);
+  EXPECT_TRUE(ranges.empty());
+}
+
+TEST(ByteRangeTest, Ignored) {
+  std::vector<ByteRange> ranges{};
+  for (std::string value : {"", "bytes", "items=0-1", "bytes=", "bytes=a-b", "bytes=5-1",
+                            "bytes=1", "bytes=0-1,x", "bytes=--1",
+                            "bytes=0-99999999999999999999999"}) {
+    EXPECT_EQ(parse_byte_ranges(value, 1000, ranges), RangeStatus::ignored) << value;
+    EXPECT_TRUE(ranges.empty()) << value;
+  }
+
+  std::string many{"bytes=0-0"};
+  for (std::size_t i = 1; i <= web_server::message::MAX_BYTE_RANGES; ++i) {
+    many += "," + std::to_string(i * 2) + "-" + std::to_string(i * 2);
+  }
+  EXPECT_EQ(parse_byte_ranges(many, 1000, ranges), RangeStatus::ignored);
+}
@@ -0,0 +1,118 @@
+#include "../include/char_scan.hpp"
+#include "../include/request_parser.hpp"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using web_server::utils::CharScanner;
+using web_server::utils::ScanLevel;
+
+namespace {
+
+std::vector<const CharScanner*> vectorized() {
+  std::vector<const CharScanner*> scanners{};
+  for (auto level : {ScanLevel::sse2, ScanLevel::avx2}) {
+    if (auto scanner = CharScanner::get(level)) {
+      scanners.push_back(scanner);
+    }
+  }
+  return scanners;
+}
+
+// Every kernel of scanner gives the scalar result from every offset, or
+// every step-th one.
+void expect_same(const CharScanner& scanner, std::string_view data, std::size_t step = 1) {
+  const auto& scalar = *CharScanner::get(ScanLevel::scalar);
+  for (std::size_t from = 0; from <= data.size(); from += step) {
+    ASSERT_EQ(scanner.skip_token(data, from), scalar.skip_token(data, from)) << from;
+    ASSERT_EQ(scanner.skip_target(data, from), scalar.skip_target(data, from)) << from;
+    ASSERT_EQ(scanner.skip_value(data, from), scalar.skip_value(data, from)) << from;
+    ASSERT_EQ(scanner.find_crlf(data, from), scalar.find_crlf(data, from)) << from;
+  }
+}
+
+} // namespace
+
+TEST(CharScanTest, Scalar) {
+  const auto& scalar = *CharScanner::get(ScanLevel::scalar);
+  std::string_view data = "Accept-Encoding: gzip, br \r\n";
+  EXPECT_EQ(scalar.skip_token(data, 0), 15);
+  EXPECT_EQ(scalar.skip_target(data, 0), 16);
+  EXPECT_EQ(scalar.skip_value(data, 16), 26);
+  EXPECT_EQ(scalar.find_crlf(data, 0), 26);
+  EXPECT_EQ(scalar.find_crlf(data, 27), std::string_view::npos);
+  EXPECT_EQ(scalar.find_crlf("\r\r\n", 0), 1);
+  EXPECT_EQ(scalar.skip_value("", 0), 0);
+}
+
+TEST(CharScanTest, EveryByteAtEveryPosition) {
+  // A byte in a run of letters, and in a run of other tchars, which the
+  // vectorized token kernels treat as possible stops.
+  for (auto scanner : vectorized()) {
+    for (std::string fill : {"a", "!"}) {
+      for (int byte = 0; byte < 256; ++byte) {
+        for (std::size_t position : {0, 1, 15, 16, 17, 31, 32, 33, 47, 63, 64}) {
+          std::string data{};
+          for (std::size_t i = 0; i < 70; ++i) {
+            data += fill;
+          }
+          data[position] = static_cast<char>(byte);
+          expect_same(*scanner, data, 17);
+          if (position + 1 < data.size()) {
+            data[position + 1] = '\n';
+            expect_same(*scanner, data, 17);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(CharScanTest, Random) {
+  std::mt19937 random{2024};
+  // Mostly header bytes, so runs get long enough to cross blocks.
+  const std::string common = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+                             "-_.!~ \t:;,/=\"\r\n";
+  for (auto scanner : vectorized()) {
+    for (int round = 0; round < 500; ++round) {
+      std::string data(random() % 200, '\0');
+      for (auto& c : data) {
+        c = random() % 8 == 0 ? static_cast<char>(random() % 256)
+                              : common[random() % common.size()];
+      }
+      expect_same(*scanner, data);
+    }
+  }
+}
+
+TEST(CharScanTest, ParserAtEveryLevel) {
+  using web_server::message::RequestParser;
+  std::string request = "GET /" + std::string(100, 'p') + "?q=" + std::string(50, '%') +
+                        " HTTP/1.1\r\n"
+                        "Host: localhost\r\n"
+                        "Cookie: " +
+                        std::string(500, 'c') + "; theme=dark  \t \r\n" +
+                        "X-Custom-Header-With-A-Long-Name_And.Other!Tchars: " +
+                        std::string(40, ' ') + "value\r\n"
+                        "\r\n";
+  auto level = CharScanner::active().level;
+  for (auto scan_level : {ScanLevel::scalar, ScanLevel::sse2, ScanLevel::avx2}) {
+    if (!CharScanner::use(scan_level)) {
+      continue;
+    }
+    RequestParser parser{};
+    ASSERT_EQ(parser.parse(request), RequestParser::Status::complete);
+    EXPECT_EQ(parser.header_size(), request.size());
+    EXPECT_EQ(parser.target().size(), 154);
+    EXPECT_EQ(parser.find("cookie"), std::string(500, 'c') + "; theme=dark");
+    EXPECT_EQ(parser.find("x-custom-header-with-a-long-name_and.other!tchars"), "value");
+
+    request[200] = '\x01';
+    parser.reset();
+    EXPECT_EQ(parser.parse(request), RequestParser::Status::error);
+    request[200] = 'c';
+  }
+  CharScanner::use(level);
+}
@@ -1,7 +1,12 @@
 #include "../include/connection_pool.hpp"
 #include "include/mock_socket.hpp"
 
+#include <atomic>
 #include <gtest/gtest.h>
+#include <optional>
+#include <set>
+#include <thread>
+#include <vector>
 
 using MockConnection = web_server::connection::Connection<MockAsioSocket>;
 using MockConnectionPool = web_server::connection::ConnectionPool<MockAsioSocket>;
@@ -24,10 +29,10 @@ TEST(ConnectionPoolTest, Constructor) {
 
 TEST(ConnectionPoolTest, Add) {
   boost::asio::io_context io_context{};
-  web_server::utils::Queue<web_server::message::Data> queue{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
   MockConnectionPool pool{10};
   MockAsioSocket socket{io_context, ""};
-  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), queue);
+  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), handler);
   auto id = pool.add(connection);
   EXPECT_GE(id, 0);
   EXPECT_EQ(pool.size(), 1);
@@ -38,10 +43,10 @@ TEST(ConnectionPoolTest, Add) {
 
 TEST(ConnectionPoolTest, Emplace) {
   boost::asio::io_context io_context{};
-  web_server::utils::Queue<web_server::message::Data> queue{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
   MockConnectionPool pool{10};
   MockAsioSocket socket{io_context, ""};
-  auto id = pool.emplace(io_context, std::move(socket), queue);
+  auto id = pool.emplace(io_context, std::move(socket), handler);
   EXPECT_GE(id, 0);
   EXPECT_EQ(pool.size(), 1);
   EXPECT_FALSE(pool.is_empty());
@@ -51,10 +56,10 @@ TEST(ConnectionPoolTest, Emplace) {
 
 TEST(ConnectionPoolTest, AddToFull) {
   boost::asio::io_context io_context{};
-  web_server::utils::Queue<web_server::message::Data> queue{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
   MockConnectionPool pool{1};
   MockAsioSocket socket{io_context, ""};
-  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), queue);
+  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), handler);
   auto id = pool.add(connection);
   EXPECT_GE(id, 0);
   EXPECT_EQ(pool.size(), 1);
@@ -63,7 +68,7 @@ TEST(ConnectionPoolTest, AddToFull) {
   EXPECT_NE(pool.get_connection(id), nullptr);
 
   MockAsioSocket socket2{io_context, ""};
-  auto connection2 = std::make_shared<MockConnection>(io_context, std::move(socket2), queue);
+  auto connection2 = std::make_shared<MockConnection>(io_context, std::move(socket2), handler);
   auto id2 = pool.add(connection2);
   EXPECT_EQ(id2, -1);
   EXPECT_EQ(pool.size(), 1);
@@ -74,10 +79,10 @@ TEST(ConnectionPoolTest, AddToFull) {
 
 TEST(ConnectionPoolTest, Erase) {
   boost::asio::io_context io_context{};
-  web_server::utils::Queue<web_server::message::Data> queue{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
   MockConnectionPool pool{10};
   MockAsioSocket socket{io_context, ""};
-  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), queue);
+  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), handler);
   auto id = pool.add(connection);
   EXPECT_GE(id, 0);
   EXPECT_EQ(pool.size(), 1);
@@ -94,10 +99,10 @@ TEST(ConnectionPoolTest, Erase) {
 
 TEST(ConnectionPoolTest, EraseAll) {
   boost::asio::io_context io_context{};
-  web_server::utils::Queue<web_server::message::Data> queue{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
   MockConnectionPool pool{10};
   MockAsioSocket socket{io_context, ""};
-  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), queue);
+  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), handler);
   auto id = pool.add(connection);
   EXPECT_GE(id, 0);
   EXPECT_EQ(pool.size(), 1);
@@ -114,10 +119,10 @@ TEST(ConnectionPoolTest, EraseAll) {
 
 TEST(ConnectionPoolTest, EraseUnavaliable) {
   boost::asio::io_context io_context{};
-  web_server::utils::Queue<web_server::message::Data> queue{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
   MockConnectionPool pool{10};
   MockAsioSocket socket{io_context, ""};
-  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), queue);
+  auto connection = std::make_shared<MockConnection>(io_context, std::move(socket), handler);
   auto id = pool.add(connection);
   EXPECT_GE(id, 0);
   EXPECT_EQ(pool.size(), 1);
@@ -139,3 +144,204 @@ TEST(ConnectionPoolTest, EraseUnavaliable) {
   EXPECT_FALSE(pool.is_full());
   EXPECT_EQ(pool.get_connection(id), nullptr);
 }
+
+TEST(ConnectionPoolTest, ReuseErasedId) {
+  boost::asio::io_context io_context{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
+  MockConnectionPool pool{4096};
+  for (int i = 0; i < 2000; ++i) {
+    EXPECT_EQ(pool.emplace(io_context, MockAsioSocket{io_context, ""}, handler), i);
+  }
+  pool.erase(1500);
+  pool.erase(1500);
+  EXPECT_EQ(pool.size(), 1999);
+  EXPECT_EQ(pool.emplace(io_context, MockAsioSocket{io_context, ""}, handler), 1500);
+  EXPECT_EQ(pool.emplace(io_context, MockAsioSocket{io_context, ""}, handler), 2000);
+}
+
+TEST(ConnectionPoolTest, ConcurrentAddErase) {
+  constexpr int THREADS = 4;
+  constexpr int ROUNDS = 2000;
+  boost::asio::io_context io_context{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
+  MockConnectionPool pool{THREADS * 8};
+
+  std::vector<std::thread> threads{};
+  std::vector<std::vector<std::int32_t>> held(THREADS);
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int round = 0; round < ROUNDS; ++round) {
+        auto connection =
+            std::make_shared<MockConnection>(io_context, MockAsioSocket{io_context, ""}, handler);
+        auto id = pool.add(connection);
+        ASSERT_GE(id, 0);
+        // Nobody else may hand out or clear this id while we hold it.
+        ASSERT_EQ(pool.get_connection(id), connection);
+        if (round % 3 == 0) {
+          held[t].push_back(id);
+          if (held[t].size() > 4) {
+            pool.erase(held[t].front());
+            held[t].erase(held[t].begin());
+          }
+        } else {
+          pool.erase(id);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::set<std::int32_t> ids{};
+  for (const auto& thread_ids : held) {
+    for (auto id : thread_ids) {
+      EXPECT_TRUE(ids.insert(id).second);
+      EXPECT_NE(pool.get_connection(id), nullptr);
+    }
+  }
+  EXPECT_EQ(pool.size(), ids.size());
+}
+
+TEST(ConnectionPoolTest, Handle) {
+  boost::asio::io_context io_context{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
+  MockConnectionPool pool{1};
+  auto id = pool.emplace(io_context, MockAsioSocket{io_context, ""}, handler);
+  auto handle = pool.handle(id);
+  auto connection = pool.get_connection(id);
+  EXPECT_TRUE(pool.is_valid(handle));
+  EXPECT_EQ(pool.get_connection(handle), connection);
+  EXPECT_EQ(pool.resolve(handle), connection.get());
+
+  pool.erase(id);
+  // The pool dropped its reference along with the slot.
+  EXPECT_EQ(connection.use_count(), 1);
+  EXPECT_FALSE(pool.is_valid(handle));
+  EXPECT_EQ(pool.get_connection(handle), nullptr);
+  EXPECT_EQ(pool.resolve(handle), nullptr);
+
+  // The slot is reused, the old handle still names the erased connection.
+  EXPECT_EQ(pool.emplace(io_context, MockAsioSocket{io_context, ""}, handler), id);
+  EXPECT_NE(pool.handle(id), handle);
+  EXPECT_EQ(pool.get_connection(handle), nullptr);
+  EXPECT_NE(pool.get_connection(pool.handle(id)), nullptr);
+  EXPECT_EQ(pool.resolve(handle), nullptr);
+  EXPECT_EQ(pool.resolve(pool.handle(id)), pool.get_connection(id).get());
+  EXPECT_FALSE(pool.is_valid(std::numeric_limits<web_server::connection::ConnectionHandle>::max()));
+
+  // Erasing by a stale handle leaves the new connection alone.
+  pool.erase(handle);
+  EXPECT_EQ(pool.size(), 1);
+  pool.erase(pool.handle(id));
+  EXPECT_TRUE(pool.is_empty());
+}
+
+// Churns connections through a small pool while other threads deliver
+// "responses" by handle: a handle must never resolve to a different connection.
+TEST(ConnectionPoolTest, StaleHandleStress) {
+  constexpr int CHURN_THREADS = 2;
+  constexpr int DELIVER_THREADS = 2;
+  constexpr int ROUNDS = 2000;
+  boost::asio::io_context io_context{};
+  web_server::connection::RequestHandler<MockAsioSocket> handler{};
+  MockConnectionPool pool{8};
+
+  std::mutex in_flight_mutex{};
+  std::vector<web_server::connection::ConnectionHandle> in_flight{};
+  std::atomic<int> churning{CHURN_THREADS};
+  std::atomic<std::uint64_t> created{0};
+  std::atomic<std::uint64_t> delivered{0};
+  std::atomic<std::uint64_t> dropped{0};
+  std::atomic<std::uint64_t> misdelivered{0};
+
+  std::vector<std::thread> threads{};
+  for (int t = 0; t < CHURN_THREADS; ++t) {
+    threads.emplace_back([&]() {
+      for (int round = 0; round < ROUNDS; ++round) {
+        auto id = pool.emplace(io_context, MockAsioSocket{io_context, ""}, handler);
+        if (id < 0) {
+          continue;
+        }
+        auto handle = pool.handle(id);
+        pool.get_connection(id)->set_handle(handle);
+        {
+          std::scoped_lock<std::mutex> lock{in_flight_mutex};
+          in_flight.push_back(handle);
+        }
+        ++created;
+        if (round % 2 == 0) {
+          std::this_thread::yield();
+        }
+        pool.erase(id);
+      }
+      --churning;
+    });
+  }
+  for (int t = 0; t < DELIVER_THREADS; ++t) {
+    threads.emplace_back([&]() {
+      while (true) {
+        std::optional<web_server::connection::ConnectionHandle> handle{};
+        {
+          std::scoped_lock<std::mutex> lock{in_flight_mutex};
+          if (!in_flight.empty()) {
+            handle = in_flight.back();
+            in_flight.pop_back();
+          }
+        }
+        if (!handle) {
+          if (churning == 0) {
+            break;
+          }
+          std::this_thread::yield();
+          continue;
+        }
+        auto connection = pool.get_connection(*handle);
+        if (connection == nullptr) {
+          ++dropped;
+        } else if (connection->handle() == *handle) {
+          ++delivered;
+        } else {
+          ++misdelivered;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(misdelivered, 0);
+  EXPECT_EQ(delivered + dropped, created);
+  EXPECT_GT(dropped, 0);
+  EXPECT_TRUE(pool.is_empty());
+}
+
+// A client that resets its connection in the middle of a request must not
+// keep its slot: the read error closes the connection, which erases it.
+TEST(ConnectionPoolTest, ReleaseResetConnection) {
+  using boost::asio::ip::tcp;
+  boost::asio::io_context io_context{};
+  tcp::acceptor acceptor{io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+  tcp::socket client{io_context};
+  client.connect(acceptor.local_endpoint());
+  web_server::connection::ConnectionPool<tcp::socket> pool{1};
+  auto id = pool.emplace(io_context, acceptor.accept(),
+                         web_server::connection::RequestHandler<tcp::socket>{});
+  ASSERT_GE(id, 0);
+  auto connection = pool.get_connection(id);
+  connection->set_close_handler([&pool, &io_context, handle = pool.handle(id)]() {
+    boost::asio::post(io_context, [&pool, handle]() { pool.erase(handle); });
+  });
+  connection->receive(id);
+  connection.reset();
+  EXPECT_TRUE(pool.is_full());
+
+  boost::asio::write(client, boost::asio::buffer(std::string("GET / HTTP/1.1\r\nHo")));
+  client.set_option(tcp::socket::linger(true, 0));
+  client.close();
+  io_context.run();
+
+  EXPECT_EQ(pool.size(), 0);
+  EXPECT_EQ(pool.get_connection(id), nullptr);
+}
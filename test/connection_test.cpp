@@ -1,37 +1,507 @@
 #include "../include/connection.hpp"
+#include "../include/queue.hpp"
 #include "include/mock_socket.hpp"
 
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <memory>
+#include <thread>
+
+// The request as it was received, for requests whose fields are spelled
+// canonically.
+std::string to_string(const web_server::message::Request& request) {
+  std::string bytes{};
+  request.to_bytes(bytes);
+  return bytes;
+}
 
 class ConnectionTest: public ::testing::Test {
 protected:
   ConnectionTest(): m_io_context(), m_socket(m_io_context, m_read), m_queue() {
     m_connection = std::make_shared<web_server::connection::Connection<MockAsioSocket>>(
-        m_io_context, std::move(m_socket), m_queue);
+        m_io_context, std::move(m_socket),
+        [this](auto connection, web_server::message::Request request) {
+          m_queue.push(std::move(request));
+        });
   }
   void SetUp() override { m_io_context.run(); }
   void TearDown() override { m_io_context.stop(); }
 
+  // Runs the handlers send() and deliver() posted to the connection's strand.
+  void run() {
+    m_io_context.restart();
+    m_io_context.run();
+  }
+
   std::string m_read = "GET / HTTP/1.1\r\nHost: www.example.com\r\nContent-Length: "
                        "11\r\n\r\nHello World";
   boost::asio::io_context m_io_context;
   MockAsioSocket m_socket;
-  web_server::utils::Queue<web_server::message::Data> m_queue;
+  web_server::utils::Queue<web_server::message::Request> m_queue;
   std::shared_ptr<web_server::connection::Connection<MockAsioSocket>> m_connection;
 };
 
 TEST_F(ConnectionTest, Receive) {
   m_connection->receive(0);
-  auto data = m_queue.pop();
-  EXPECT_EQ(data.connection_id(), 0);
-  EXPECT_EQ(data.size(), m_read.size());
-  EXPECT_EQ(std::string((char*)data.data(), data.size()), m_read);
+  auto request = m_queue.pop();
+  EXPECT_EQ(request.connection_id(), 0);
+  EXPECT_EQ(to_string(request), m_read);
+  EXPECT_EQ(request.header().get("Host"), "www.example.com");
+  EXPECT_EQ(request.body(), "Hello World");
 }
 
 TEST_F(ConnectionTest, Send) {
   web_server::message::Data data(reinterpret_cast<const std::uint8_t*>(m_read.data()),
                                  m_read.size(), 0);
   m_connection->send(data);
+  run();
   EXPECT_EQ(m_connection->socket().get_write(), m_read);
 }
+
+TEST(ConnectionPipelineTest, DeliverInOrder) {
+  using web_server::message::Data;
+  using web_server::message::Request;
+  boost::asio::io_context io_context{};
+  std::string read = "GET /a HTTP/1.1\r\nHost: www.example.com\r\n\r\n"
+                     "POST /b HTTP/1.1\r\nContent-Length: 5\r\n\r\nHello"
+                     "GET /c HTTP/1.1\r\n\r\n";
+  MockAsioSocket socket{io_context, read};
+  std::vector<Request> requests{};
+  auto connection = std::make_shared<web_server::connection::Connection<MockAsioSocket>>(
+      io_context, std::move(socket),
+      [&requests](auto connection, Request request) { requests.push_back(std::move(request)); });
+
+  connection->receive(0);
+  ASSERT_EQ(requests.size(), 3);
+  EXPECT_EQ(to_string(requests[0]), "GET /a HTTP/1.1\r\nHost: www.example.com\r\n\r\n");
+  EXPECT_EQ(to_string(requests[1]), "POST /b HTTP/1.1\r\nContent-Length: 5\r\n\r\nHello");
+  EXPECT_EQ(to_string(requests[2]), "GET /c HTTP/1.1\r\n\r\n");
+  for (std::uint64_t i = 0; i < requests.size(); ++i) {
+    EXPECT_EQ(requests[i].sequence(), i);
+  }
+
+  auto respond = [&connection](std::uint64_t sequence, const std::string& body) {
+    Data response(reinterpret_cast<const std::uint8_t*>(body.data()), body.size(), 0);
+    response.set_sequence(sequence);
+    connection->deliver(std::move(response));
+  };
+  respond(2, "c");
+  respond(1, "b");
+  io_context.restart();
+  io_context.run();
+  EXPECT_EQ(connection->socket().get_write(), "");
+  respond(0, "a");
+  io_context.restart();
+  io_context.run();
+  EXPECT_EQ(connection->socket().get_write(), "abc");
+  // The three queued responses go out in one gathered write.
+  EXPECT_EQ(connection->socket().get_write_count(), 1);
+}
+
+TEST(ConnectionPipelineTest, PauseReading) {
+  using web_server::message::Data;
+  using web_server::message::Request;
+  boost::asio::io_context io_context{};
+  std::string read{};
+  for (int i = 0; i < 5; ++i) {
+    read += "GET /" + std::to_string(i) + " HTTP/1.1\r\n\r\n";
+  }
+  MockAsioSocket socket{io_context, read};
+  std::vector<Request> requests{};
+  auto connection = std::make_shared<web_server::connection::Connection<MockAsioSocket>>(
+      io_context, std::move(socket),
+      [&requests](auto connection, Request request) { requests.push_back(std::move(request)); });
+  connection->set_pipeline_watermarks(2, 1);
+
+  connection->receive(0);
+  EXPECT_EQ(requests.size(), 2);
+
+  auto respond = [&](std::uint64_t sequence) {
+    Data response(reinterpret_cast<const std::uint8_t*>("x"), 1, 0);
+    response.set_sequence(sequence);
+    connection->deliver(std::move(response));
+    io_context.restart();
+    io_context.run();
+  };
+  // Writing the first response drains the pipeline to the low watermark.
+  respond(0);
+  EXPECT_EQ(requests.size(), 3);
+  respond(1);
+  respond(2);
+  EXPECT_EQ(requests.size(), 5);
+  EXPECT_EQ(to_string(requests[4]), "GET /4 HTTP/1.1\r\n\r\n");
+}
+
+TEST_F(ConnectionTest, DeliverSegments) {
+  using web_server::message::Buffer;
+  std::string shared = "0123456789";
+  web_server::message::Payload payload{0};
+  payload.append(Buffer::view("HTTP/1.1 200 OK\r\n"));
+  payload.append(Buffer::own(std::string("Content-Length: 4\r\n\r\n")));
+  payload.append(Buffer::view(shared).slice(3, 4));
+  EXPECT_EQ(payload.segments().size(), 3);
+  EXPECT_EQ(payload.size(), 42);
+
+  m_connection->deliver(std::move(payload));
+  run();
+  EXPECT_EQ(m_connection->socket().get_write(),
+            "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\n3456");
+}
+
+TEST_F(ConnectionTest, SendKeepsDataAlive) {
+  {
+    std::string body = "queued after the caller's data is gone";
+    web_server::message::Data data(reinterpret_cast<const std::uint8_t*>(body.data()),
+                                   body.size(), 0);
+    m_connection->send(std::move(data));
+    m_connection->send(web_server::message::Data(
+        reinterpret_cast<const std::uint8_t*>(body.data()), body.size(), 0));
+  }
+  run();
+  EXPECT_EQ(m_connection->socket().get_write(),
+            "queued after the caller's data is gone"
+            "queued after the caller's data is gone");
+}
+
+TEST(ConnectionFileTest, DeliverFileRegion) {
+  using boost::asio::ip::tcp;
+  auto path = std::filesystem::temp_directory_path() / "connection_file_test.bin";
+  std::string content(3 * 1024 * 1024, '\0');
+  for (std::size_t i = 0; i < content.size(); ++i) {
+    content[i] = static_cast<char>('a' + i % 26);
+  }
+  std::ofstream(path, std::ios::binary) << content;
+
+  boost::asio::io_context io_context{};
+  tcp::acceptor acceptor{io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+  tcp::socket client{io_context};
+  client.connect(acceptor.local_endpoint());
+  auto connection = std::make_shared<web_server::connection::Connection<tcp::socket>>(
+      io_context, acceptor.accept(), web_server::connection::RequestHandler<tcp::socket>{});
+
+  std::string head = "HEAD\r\n";
+  std::string tail = "\r\nTAIL";
+  web_server::message::Payload payload{0};
+  payload.append(web_server::message::Buffer::view(head));
+  payload.append(web_server::message::FileRegion(web_server::message::File::open(path), 7,
+                                                 content.size() - 14));
+  payload.append(web_server::message::Buffer::view(tail));
+  boost::asio::post(io_context, [&]() { connection->deliver(std::move(payload)); });
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::string expected = head + content.substr(7, content.size() - 14) + tail;
+  std::string received(expected.size(), '\0');
+  boost::asio::read(client, boost::asio::buffer(received));
+  EXPECT_EQ(received, expected);
+
+  io_thread.join();
+  std::filesystem::remove(path);
+}
+
+TEST(ConnectionFileTest, CopyNonRegularFile) {
+  using boost::asio::ip::tcp;
+  // Not a regular file, so it is copied through the chunk ring instead of sendfile(2).
+  auto file = web_server::message::File::open("/dev/zero");
+  ASSERT_NE(file, nullptr);
+  ASSERT_FALSE(file->is_regular());
+
+  boost::asio::io_context io_context{};
+  tcp::acceptor acceptor{io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+  tcp::socket client{io_context};
+  client.connect(acceptor.local_endpoint());
+  auto connection = std::make_shared<web_server::connection::Connection<tcp::socket>>(
+      io_context, acceptor.accept(), web_server::connection::RequestHandler<tcp::socket>{});
+
+  // Several chunk rings long and not a multiple of the chunk size.
+  std::uint64_t length = 5 * 1024 * 1024 + 123;
+  std::string tail = "TAIL";
+  web_server::message::Payload payload{0};
+  payload.append(web_server::message::Buffer::view("HEAD"));
+  payload.append(web_server::message::FileRegion(file, 0, length));
+  payload.append(web_server::message::Buffer::view(tail));
+  boost::asio::post(io_context, [&]() { connection->deliver(std::move(payload)); });
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::string received(4 + length + tail.size(), 'x');
+  boost::asio::read(client, boost::asio::buffer(received));
+  EXPECT_EQ(received.substr(0, 4), "HEAD");
+  EXPECT_EQ(received.find_first_not_of('\0', 4), 4 + length);
+  EXPECT_EQ(received.substr(4 + length), tail);
+
+  io_thread.join();
+}
+
+// The same copy with the reads on a thread pool, completing on the strand.
+TEST(ConnectionFileTest, CopyOnThreadPool) {
+  using boost::asio::ip::tcp;
+  auto file = web_server::message::File::open("/dev/zero");
+  ASSERT_NE(file, nullptr);
+  web_server::thread::ThreadPool thread_pool{2};
+
+  boost::asio::io_context io_context{};
+  tcp::acceptor acceptor{io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+  tcp::socket client{io_context};
+  client.connect(acceptor.local_endpoint());
+  auto connection = std::make_shared<web_server::connection::Connection<tcp::socket>>(
+      io_context, acceptor.accept(), web_server::connection::RequestHandler<tcp::socket>{});
+  connection->set_file_thread_pool(&thread_pool);
+
+  std::uint64_t length = 3 * 1024 * 1024 + 45;
+  web_server::message::Payload payload{0};
+  payload.append(web_server::message::Buffer::view("HEAD"));
+  payload.append(web_server::message::FileRegion(file, 0, length));
+  payload.append(web_server::message::Buffer::view("TAIL"));
+  boost::asio::post(io_context, [&]() { connection->deliver(std::move(payload)); });
+  // Keeps run() going while the reads are in flight on the pool.
+  auto work = boost::asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::string received(4 + length + 4, 'x');
+  boost::asio::read(client, boost::asio::buffer(received));
+  EXPECT_EQ(received.substr(0, 4), "HEAD");
+  EXPECT_EQ(received.find_first_not_of('\0', 4), 4 + length);
+  EXPECT_EQ(received.substr(4 + length), "TAIL");
+
+  work.reset();
+  io_context.stop();
+  io_thread.join();
+}
+
+// A file that shrinks after its header went out cannot fill the promised
+// length; the connection is closed instead of waiting for the missing bytes.
+TEST(ConnectionFileTest, TruncatedFile) {
+  using boost::asio::ip::tcp;
+  auto path = std::filesystem::temp_directory_path() / "connection_truncated_test.bin";
+  std::ofstream(path, std::ios::binary) << std::string(64 * 1024, 'a');
+  auto file = web_server::message::File::open(path);
+  ASSERT_NE(file, nullptr);
+  std::filesystem::resize_file(path, 1024);
+
+  boost::asio::io_context io_context{};
+  tcp::acceptor acceptor{io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+  tcp::socket client{io_context};
+  client.connect(acceptor.local_endpoint());
+  auto connection = std::make_shared<web_server::connection::Connection<tcp::socket>>(
+      io_context, acceptor.accept(), web_server::connection::RequestHandler<tcp::socket>{});
+
+  web_server::message::Payload payload{0};
+  payload.append(web_server::message::Buffer::view("HEAD"));
+  payload.append(web_server::message::FileRegion(file, 0, 64 * 1024));
+  boost::asio::post(io_context, [&]() { connection->deliver(std::move(payload)); });
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  std::string received{};
+  boost::system::error_code ec;
+  boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+  EXPECT_EQ(ec, boost::asio::error::eof);
+  EXPECT_EQ(received, "HEAD" + std::string(1024, 'a'));
+
+  io_thread.join();
+  EXPECT_FALSE(connection->is_connected());
+  std::filesystem::remove(path);
+}
+
+TEST(ConnectionTimeoutTest, CloseIdleConnection) {
+  using boost::asio::ip::tcp;
+  boost::asio::io_context io_context{};
+  tcp::acceptor acceptor{io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+  tcp::socket client{io_context};
+  client.connect(acceptor.local_endpoint());
+  auto connection = std::make_shared<web_server::connection::Connection<tcp::socket>>(
+      io_context, acceptor.accept(), web_server::connection::RequestHandler<tcp::socket>{});
+  web_server::connection::Timeouts timeouts{};
+  timeouts.idle = std::chrono::milliseconds(50);
+  connection->set_timeouts(timeouts);
+  connection->receive(0);
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread io_thread([&io_context]() { io_context.run(); });
+  char byte{};
+  boost::system::error_code ec;
+  client.read_some(boost::asio::buffer(&byte, 1), ec);
+  EXPECT_EQ(ec, boost::asio::error::eof);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+
+  io_thread.join();
+  EXPECT_FALSE(connection->is_connected());
+}
+
+TEST(ConnectionLimitsTest, RequestLineTooLong) {
+  using web_server::message::Data;
+  using web_server::message::Request;
+  boost::asio::io_context io_context{};
+  std::string read = "GET /" + std::string(100, 'a') + " HTTP/1.1\r\n\r\n";
+  MockAsioSocket socket{io_context, read};
+  std::vector<Request> requests{};
+  auto connection = std::make_shared<web_server::connection::Connection<MockAsioSocket>>(
+      io_context, std::move(socket),
+      [&requests](auto connection, Request request) { requests.push_back(std::move(request)); });
+  web_server::connection::Limits limits{};
+  limits.max_request_line = 64;
+  connection->set_limits(limits);
+
+  connection->receive(0);
+  io_context.run();
+  EXPECT_TRUE(requests.empty());
+  EXPECT_EQ(connection->socket().get_write(), web_server::assets::URI_TOO_LONG_RESPONSE);
+  EXPECT_FALSE(connection->is_connected());
+}
+
+TEST(ConnectionLimitsTest, HeaderTooLarge) {
+  using web_server::message::Data;
+  using web_server::message::Request;
+  boost::asio::io_context io_context{};
+  // A valid request, then one whose header never ends within the limit.
+  std::string read = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n";
+  for (int i = 0; i < 1000; ++i) {
+    read += "X-Filler: " + std::to_string(i) + "\r\n";
+  }
+  MockAsioSocket socket{io_context, read};
+  std::vector<Request> requests{};
+  auto connection = std::make_shared<web_server::connection::Connection<MockAsioSocket>>(
+      io_context, std::move(socket),
+      [&requests](auto connection, Request request) { requests.push_back(std::move(request)); });
+  web_server::connection::Limits limits{};
+  limits.max_header_size = 1024;
+  connection->set_limits(limits);
+
+  connection->receive(0);
+  ASSERT_EQ(requests.size(), 1);
+  EXPECT_EQ(to_string(requests[0]), "GET /a HTTP/1.1\r\n\r\n");
+  EXPECT_TRUE(connection->is_connected());
+
+  // The refusal waits for the response to the first request.
+  Data response(reinterpret_cast<const std::uint8_t*>("a"), 1, 0);
+  response.set_sequence(0);
+  connection->deliver(std::move(response));
+  io_context.restart();
+  io_context.run();
+  EXPECT_EQ(connection->socket().get_write(),
+            "a" + web_server::assets::REQUEST_HEADER_FIELDS_TOO_LARGE_RESPONSE);
+  EXPECT_FALSE(connection->is_connected());
+}
+
+TEST(ConnectionTimeoutTest, SlowHeader) {
+  using boost::asio::ip::tcp;
+  boost::asio::io_context io_context{};
+  tcp::acceptor acceptor{io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+  tcp::socket client{io_context};
+  client.connect(acceptor.local_endpoint());
+  auto connection = std::make_shared<web_server::connection::Connection<tcp::socket>>(
+      io_context, acceptor.accept(), web_server::connection::RequestHandler<tcp::socket>{});
+  web_server::connection::Timeouts timeouts{};
+  timeouts.header = std::chrono::milliseconds(200);
+  connection->set_timeouts(timeouts);
+  connection->receive(0);
+  std::thread io_thread([&io_context]() { io_context.run(); });
+
+  // Trickling the header byte by byte does not extend its deadline.
+  auto start = std::chrono::steady_clock::now();
+  std::string header = "GET / HTTP/1.1\r\nX-Slow: ";
+  boost::system::error_code ec;
+  for (std::size_t i = 0; !ec && std::chrono::steady_clock::now() - start < std::chrono::seconds(5);
+       ++i) {
+    boost::asio::write(client, boost::asio::buffer(i < header.size() ? &header[i] : "a", 1), ec);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_TRUE(ec);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+  io_thread.join();
+  EXPECT_FALSE(connection->is_connected());
+}
+
+TEST(ConnectionBodyTest, StreamChunkedBody) {
+  using web_server::message::Data;
+  using web_server::message::Request;
+  boost::asio::io_context io_context{};
+  std::string read = "POST /a HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                     "5\r\nHello\r\n6\r\n World\r\n0\r\n\r\n"
+                     "GET /b HTTP/1.1\r\n\r\n";
+  MockAsioSocket socket{io_context, read};
+  std::vector<Request> requests{};
+  std::string body{};
+  bool last = false;
+  auto connection = std::make_shared<web_server::connection::Connection<MockAsioSocket>>(
+      io_context, std::move(socket),
+      [&requests](auto connection, Request request) { requests.push_back(std::move(request)); });
+  connection->set_body_handler([&](auto connection, Data chunk, bool is_last) {
+    EXPECT_EQ(chunk.sequence(), 0);
+    EXPECT_FALSE(last);
+    body += chunk.to_string();
+    last = is_last;
+  });
+
+  connection->receive(0);
+  ASSERT_EQ(requests.size(), 2);
+  EXPECT_EQ(to_string(requests[0]), "POST /a HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n");
+  EXPECT_EQ(to_string(requests[1]), "GET /b HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(requests[1].sequence(), 1);
+  EXPECT_EQ(body, "Hello World");
+  EXPECT_TRUE(last);
+}
+
+TEST(ConnectionBodyTest, StreamLargeBody) {
+  using web_server::message::Data;
+  using web_server::message::Request;
+  boost::asio::io_context io_context{};
+  std::string content(1024 * 1024, 'x');
+  std::string read = "PUT /a HTTP/1.1\r\nContent-Length: " + std::to_string(content.size()) +
+                     "\r\n\r\n" + content + "GET /b HTTP/1.1\r\n\r\n";
+  MockAsioSocket socket{io_context, read};
+  std::vector<Request> requests{};
+  std::size_t body_size = 0;
+  std::size_t chunks = 0;
+  auto connection = std::make_shared<web_server::connection::Connection<MockAsioSocket>>(
+      io_context, std::move(socket),
+      [&requests](auto connection, Request request) { requests.push_back(std::move(request)); });
+  connection->set_body_handler([&](auto connection, Data chunk, bool last) {
+    body_size += chunk.size();
+    ++chunks;
+  });
+
+  connection->receive(0);
+  ASSERT_EQ(requests.size(), 2);
+  EXPECT_EQ(to_string(requests[1]), "GET /b HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(body_size, content.size());
+  // Read and handed over a bounded piece at a time.
+  EXPECT_GE(chunks, content.size() / (64 * 1024));
+}
+
+TEST(ConnectionBodyTest, MalformedChunkedBody) {
+  using web_server::message::Data;
+  using web_server::message::Request;
+  boost::asio::io_context io_context{};
+  std::string read = "POST /a HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n";
+  MockAsioSocket socket{io_context, read};
+  std::vector<Request> requests{};
+  auto connection = std::make_shared<web_server::connection::Connection<MockAsioSocket>>(
+      io_context, std::move(socket),
+      [&requests](auto connection, Request request) { requests.push_back(std::move(request)); });
+
+  connection->receive(0);
+  ASSERT_EQ(requests.size(), 1);
+  Data response(reinterpret_cast<const std::uint8_t*>("a"), 1, 0);
+  connection->deliver(std::move(response));
+  io_context.run();
+  EXPECT_EQ(connection->socket().get_write(), "a" + web_server::assets::BAD_REQUEST_RESPONSE);
+  EXPECT_FALSE(connection->is_connected());
+}
+
+TEST(ConnectionLimitsTest, UnknownMethod) {
+  using web_server::message::Data;
+  using web_server::message::Request;
+  boost::asio::io_context io_context{};
+  MockAsioSocket socket{io_context, "BREW /pot HTTP/1.1\r\n\r\n"};
+  std::vector<Request> requests{};
+  auto connection = std::make_shared<web_server::connection::Connection<MockAsioSocket>>(
+      io_context, std::move(socket),
+      [&requests](auto connection, Request request) { requests.push_back(std::move(request)); });
+
+  connection->receive(0);
+  io_context.run();
+  EXPECT_TRUE(requests.empty());
+  EXPECT_EQ(connection->socket().get_write(), web_server::assets::NOT_IMPLEMENTED_RESPONSE);
+  EXPECT_FALSE(connection->is_connected());
+}
@@ -0,0 +1,89 @@
+#include "../include/content_coding.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <zlib.h>
+
+using web_server::message::AcceptedCodings;
+using web_server::message::coding_extension;
+
+namespace {
+
+std::string gunzip(const std::string& compressed) {
+  z_stream stream{};
+  EXPECT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+  stream.avail_in = compressed.size();
+  std::string data{};
+  char buffer[4096];
+  int ret;
+  do {
+    stream.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream.avail_out = sizeof(buffer);
+    ret = inflate(&stream, Z_NO_FLUSH);
+    data.append(buffer, sizeof(buffer) - stream.avail_out);
+  } while (ret == Z_OK);
+  inflateEnd(&stream);
+  EXPECT_EQ(ret, Z_STREAM_END);
+  return data;
+}
+
+} // namespace
+
+TEST(ContentCodingTest, Accept) {
+  auto accepted = AcceptedCodings::parse("gzip, deflate, br");
+  EXPECT_TRUE(accepted.br);
+  EXPECT_TRUE(accepted.gzip);
+  EXPECT_EQ(accepted.name(), "br,gzip");
+
+  accepted = AcceptedCodings::parse("GZIP;q=0.8");
+  EXPECT_FALSE(accepted.br);
+  EXPECT_TRUE(accepted.gzip);
+  EXPECT_EQ(accepted.name(), "gzip");
+
+  accepted = AcceptedCodings::parse("identity");
+  EXPECT_FALSE(accepted.any());
+  EXPECT_EQ(accepted.name(), "");
+}
+
+TEST(ContentCodingTest, Refused) {
+  auto accepted = AcceptedCodings::parse("br;q=0, gzip; q=0.000");
+  EXPECT_FALSE(accepted.any());
+
+  accepted = AcceptedCodings::parse("br;q=0.001, gzip;q=0");
+  EXPECT_TRUE(accepted.br);
+  EXPECT_FALSE(accepted.gzip);
+
+  accepted = AcceptedCodings::parse("*");
+  EXPECT_EQ(accepted.name(), "br,gzip");
+
+  accepted = AcceptedCodings::parse("*;q=0.5, br;q=0");
+  EXPECT_EQ(accepted.name(), "gzip");
+
+  accepted = AcceptedCodings::parse("gzip, *;q=0");
+  EXPECT_EQ(accepted.name(), "gzip");
+}
+
+TEST(ContentCodingTest, Extension) {
+  EXPECT_EQ(coding_extension("br"), ".br");
+  EXPECT_EQ(coding_extension("gzip"), ".gz");
+  EXPECT_EQ(coding_extension(""), "");
+}
+
+TEST(ContentCodingTest, Gzip) {
+  std::string data{};
+  for (int i = 0; i < 20000; ++i) {
+    data += "line " + std::to_string(i % 977) + " of a compressible text file\n";
+  }
+  ASSERT_GT(data.size(), 512 * 1024);
+
+  std::string compressed{};
+  ASSERT_TRUE(web_server::message::gzip(data, compressed));
+  EXPECT_LT(compressed.size(), data.size() / 4);
+  EXPECT_EQ(static_cast<unsigned char>(compressed[0]), 0x1f);
+  EXPECT_EQ(static_cast<unsigned char>(compressed[1]), 0x8b);
+  EXPECT_EQ(gunzip(compressed), data);
+
+  ASSERT_TRUE(web_server::message::gzip("", compressed));
+  EXPECT_EQ(gunzip(compressed), "");
+}
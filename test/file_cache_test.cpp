@@ -0,0 +1,178 @@
+#include "../include/file_cache.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+using web_server::message::CachedFile;
+using web_server::message::FileCache;
+using web_server::message::FileCacheOptions;
+
+class FileCacheTest: public ::testing::Test {
+protected:
+  void SetUp() override {
+    m_root = std::filesystem::temp_directory_path() / "file_cache_test";
+    std::filesystem::remove_all(m_root);
+    std::filesystem::create_directories(m_root / "dir");
+    m_root = std::filesystem::canonical(m_root);
+  }
+  void TearDown() override { std::filesystem::remove_all(m_root); }
+
+  // Files modified within the last second are not cached.
+  std::filesystem::path write(const std::filesystem::path& name, const std::string& content,
+                              bool old = true) {
+    auto path = m_root / name;
+    std::ofstream(path, std::ios::binary) << content;
+    if (old) {
+      std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() -
+                                                 std::chrono::seconds(10));
+    }
+    return path;
+  }
+
+  // Waits for the watcher to drop the entry under key.
+  bool dropped(FileCache& cache, const std::filesystem::path& key) {
+    for (int i = 0; i < 200; ++i) {
+      if (!cache.find(key)) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+
+  static void prepare(CachedFile& file) {
+    file.header = "size " + std::to_string(file.body.size());
+  }
+
+  std::filesystem::path m_root;
+};
+
+TEST_F(FileCacheTest, Load) {
+  FileCache cache{m_root};
+  ASSERT_TRUE(cache.enabled());
+  auto path = write("a.txt", "hello");
+  EXPECT_EQ(cache.find(path), nullptr);
+
+  auto entry = cache.load(path, path, prepare);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->body, "hello");
+  EXPECT_EQ(entry->header, "size 5");
+  EXPECT_EQ(entry->path, path);
+  EXPECT_EQ(entry->metadata.size, 5);
+
+  EXPECT_EQ(cache.find(path), entry);
+  EXPECT_EQ(cache.count(), 1);
+  EXPECT_GT(cache.size(), 5);
+  EXPECT_EQ(cache.stats().hits, 1);
+  EXPECT_EQ(cache.stats().misses, 1);
+}
+
+TEST_F(FileCacheTest, DirectoryIndex) {
+  FileCache cache{m_root};
+  auto path = write("dir/index.html", "index");
+  ASSERT_NE(cache.load(m_root / "dir", path, prepare), nullptr);
+  ASSERT_NE(cache.load(m_root / "dir/", path, prepare), nullptr);
+  EXPECT_EQ(cache.find(m_root / "dir")->body, "index");
+  EXPECT_EQ(cache.find(m_root / "dir/")->body, "index");
+
+  // Only a directory's index.html is cached under the directory.
+  auto other = write("dir/other.html", "other");
+  EXPECT_EQ(cache.load(m_root / "dir", other, prepare), nullptr);
+
+  cache.invalidate(path);
+  EXPECT_EQ(cache.find(m_root / "dir"), nullptr);
+  EXPECT_EQ(cache.find(m_root / "dir/"), nullptr);
+}
+
+TEST_F(FileCacheTest, Rejected) {
+  FileCacheOptions options{};
+  options.max_file_size = 8;
+  FileCache cache{m_root, options};
+
+  auto large = write("large.txt", "0123456789");
+  EXPECT_EQ(cache.load(large, large, prepare), nullptr);
+  auto recent = write("recent.txt", "new", false);
+  EXPECT_EQ(cache.load(recent, recent, prepare), nullptr);
+  auto link = m_root / "link.txt";
+  std::filesystem::create_symlink(write("target.txt", "target"), link);
+  EXPECT_EQ(cache.load(link, link, prepare), nullptr);
+  auto outside = m_root / "dir/../target.txt";
+  EXPECT_EQ(cache.load(outside, outside, prepare), nullptr);
+  EXPECT_EQ(cache.load(m_root / "dir", m_root / "dir", prepare), nullptr);
+  EXPECT_EQ(cache.count(), 0);
+
+  FileCache disabled{m_root, FileCacheOptions{0, 8}};
+  EXPECT_FALSE(disabled.enabled());
+  auto path = write("a.txt", "a");
+  EXPECT_EQ(disabled.load(path, path, prepare), nullptr);
+}
+
+TEST_F(FileCacheTest, Eviction) {
+  // Every shard has room for one entry.
+  FileCacheOptions options{};
+  options.capacity = 16 * 1024;
+  FileCache cache{m_root, options};
+
+  // Written before the first load watches the directory: a change reported
+  // while a file is loaded keeps it out of the cache.
+  std::vector<std::filesystem::path> paths{};
+  for (int i = 0; i < 32; ++i) {
+    paths.push_back(write("file" + std::to_string(i), std::string(600, 'x')));
+  }
+  auto large = write("large", std::string(2048, 'y'));
+  for (const auto& path : paths) {
+    ASSERT_NE(cache.load(path, path, prepare), nullptr);
+  }
+  EXPECT_LE(cache.count(), 16);
+  EXPECT_LE(cache.size(), options.capacity);
+  EXPECT_EQ(cache.stats().evictions, 32 - cache.count());
+  // The last file loaded is always kept.
+  EXPECT_NE(cache.find(paths.back()), nullptr);
+
+  // An entry over the budget of its shard is returned but not kept.
+  EXPECT_NE(cache.load(large, large, prepare), nullptr);
+  EXPECT_EQ(cache.find(large), nullptr);
+}
+
+TEST_F(FileCacheTest, Invalidation) {
+  FileCache cache{m_root};
+  auto path = write("a.txt", "hello");
+  auto nested = write("dir/b.txt", "nested");
+  ASSERT_NE(cache.load(path, path, prepare), nullptr);
+  ASSERT_NE(cache.load(nested, nested, prepare), nullptr);
+
+  std::ofstream(path, std::ios::app) << " world";
+  EXPECT_TRUE(dropped(cache, path));
+  EXPECT_NE(cache.find(nested), nullptr);
+
+  std::filesystem::rename(m_root / "dir", m_root / "moved");
+  EXPECT_TRUE(dropped(cache, nested));
+  EXPECT_EQ(cache.count(), 0);
+  EXPECT_EQ(cache.stats().invalidations, 2);
+}
+
+TEST_F(FileCacheTest, Variants) {
+  FileCache cache{m_root};
+  auto path = write("app.js", "plain");
+  auto sibling = write("app.js.br", "brotli");
+  ASSERT_NE(cache.load(path, path, prepare), nullptr);
+  ASSERT_NE(cache.load(path, sibling, prepare, "br"), nullptr);
+  ASSERT_NE(cache.load(path, path, prepare, "gzip"), nullptr);
+  EXPECT_EQ(cache.find(path)->body, "plain");
+  EXPECT_EQ(cache.find(path, "br")->body, "brotli");
+  EXPECT_EQ(cache.find(path, "br,gzip"), nullptr);
+
+  // Siblings only belong to their own file.
+  EXPECT_EQ(cache.load(m_root / "other.js", sibling, prepare, "br"), nullptr);
+  EXPECT_EQ(cache.load(path, sibling, prepare, "deflate"), nullptr);
+
+  // A change of a sibling drops every variant of its file.
+  cache.invalidate(sibling);
+  EXPECT_EQ(cache.find(path), nullptr);
+  EXPECT_EQ(cache.find(path, "br"), nullptr);
+  EXPECT_EQ(cache.find(path, "gzip"), nullptr);
+  EXPECT_EQ(cache.stats().invalidations, 3);
+}
@@ -0,0 +1,99 @@
+#include "../include/file_region.hpp"
+
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class FileRegionTest: public ::testing::Test {
+protected:
+  void SetUp() override {
+    m_path = std::filesystem::temp_directory_path() / "file_region_test.txt";
+    std::ofstream out(m_path, std::ios::binary);
+    out << m_content;
+  }
+  void TearDown() override { std::filesystem::remove(m_path); }
+
+  std::filesystem::path m_path;
+  std::string m_content = "0123456789abcdefghijklmnopqrstuvwxyz";
+};
+
+TEST_F(FileRegionTest, Open) {
+  auto file = web_server::message::File::open(m_path);
+  ASSERT_NE(file, nullptr);
+  EXPECT_TRUE(file->is_regular());
+  EXPECT_EQ(file->size(), m_content.size());
+
+  EXPECT_EQ(web_server::message::File::open(m_path.string() + ".missing"), nullptr);
+}
+
+TEST_F(FileRegionTest, Metadata) {
+  auto metadata = web_server::message::FileMetadata::stat(m_path);
+  ASSERT_TRUE(metadata);
+  EXPECT_TRUE(metadata->is_regular);
+  EXPECT_FALSE(metadata->is_directory);
+  EXPECT_EQ(metadata->size, m_content.size());
+
+  auto file = web_server::message::File::open(m_path);
+  EXPECT_EQ(file->metadata().inode, metadata->inode);
+  EXPECT_EQ(file->modified(), metadata->modified);
+
+  EXPECT_TRUE(web_server::message::FileMetadata::stat(m_path.parent_path())->is_directory);
+  EXPECT_FALSE(web_server::message::FileMetadata::stat(m_path.string() + ".missing"));
+}
+
+TEST_F(FileRegionTest, Read) {
+  web_server::message::FileRegion region{web_server::message::File::open(m_path), 10, 20};
+  std::string buffer(8, '\0');
+  std::error_code ec;
+
+  auto size = region.read(0, reinterpret_cast<std::uint8_t*>(buffer.data()), buffer.size(), ec);
+  EXPECT_FALSE(ec);
+  EXPECT_EQ(size, 8);
+  EXPECT_EQ(buffer, "abcdefgh");
+
+  size = region.read(16, reinterpret_cast<std::uint8_t*>(buffer.data()), buffer.size(), ec);
+  EXPECT_FALSE(ec);
+  EXPECT_EQ(size, 4);
+  EXPECT_EQ(buffer.substr(0, size), "qrst");
+}
+
+TEST_F(FileRegionTest, SendTo) {
+  web_server::message::FileRegion region{web_server::message::File::open(m_path), 10, 20};
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+  std::error_code ec;
+  std::uint64_t sent = region.send_to(fds[0], 0, ec);
+  EXPECT_FALSE(ec);
+  while (!ec && sent < region.length()) {
+    sent += region.send_to(fds[0], sent, ec);
+  }
+  EXPECT_EQ(sent, 20);
+
+  std::string received(20, '\0');
+  EXPECT_EQ(::read(fds[1], received.data(), received.size()), 20);
+  EXPECT_EQ(received, m_content.substr(10, 20));
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST_F(FileRegionTest, SendTruncated) {
+  web_server::message::FileRegion region{web_server::message::File::open(m_path), 10, 20};
+  std::filesystem::resize_file(m_path, 20);
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+  std::error_code ec;
+  std::uint64_t sent = 0;
+  for (int i = 0; i < 4 && !ec && sent < region.length(); ++i) {
+    sent += region.send_to(fds[0], sent, ec);
+  }
+  EXPECT_EQ(ec, std::errc::io_error);
+  EXPECT_EQ(sent, 10);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
@@ -0,0 +1,124 @@
+#include "../include/header_map.hpp"
+
+#include <cctype>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using web_server::message::header_id;
+using web_server::message::header_name;
+using web_server::message::HEADER_ID_COUNT;
+using web_server::message::HeaderId;
+using web_server::message::HeaderMap;
+using web_server::message::HeaderViewMap;
+
+TEST(HeaderMapTest, HeaderIds) {
+  for (std::size_t i = 0; i < HEADER_ID_COUNT; ++i) {
+    auto id = static_cast<HeaderId>(i);
+    auto name = std::string(header_name(id));
+    EXPECT_EQ(header_id(name), id) << name;
+    for (auto& c : name) {
+      c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    EXPECT_EQ(header_id(name), id) << name;
+  }
+  EXPECT_EQ(header_id("CONTENT-LENGTH"), HeaderId::content_length);
+  EXPECT_EQ(header_id("Content-Lengths"), HeaderId::other);
+  EXPECT_EQ(header_id("X-Request-Id"), HeaderId::other);
+  EXPECT_EQ(header_id(""), HeaderId::other);
+  EXPECT_EQ(header_name(HeaderId::other), "");
+}
+
+TEST(HeaderMapTest, CaseInsensitive) {
+  HeaderMap headers{};
+  headers.add("content-length", "5");
+  headers.add("X-Request-Id", "abc");
+
+  EXPECT_TRUE(headers.contains(HeaderId::content_length));
+  EXPECT_TRUE(headers.contains("Content-Length"));
+  EXPECT_EQ(headers.at("CONTENT-LENGTH"), "5");
+  EXPECT_EQ(*headers.find("x-request-id"), "abc");
+  EXPECT_EQ(headers.find(HeaderId::host), nullptr);
+  EXPECT_EQ(headers.find("X-Other"), nullptr);
+  EXPECT_THROW(headers.at("Host"), std::out_of_range);
+  EXPECT_THROW(headers.at(HeaderId::host), std::out_of_range);
+}
+
+TEST(HeaderMapTest, Order) {
+  HeaderMap headers{};
+  headers.add("host", "localhost");
+  headers.add("X-Custom", "1");
+  headers.add("accept", "*/*");
+
+  // Well-known names are spelled canonically, others as they were added.
+  std::string names{};
+  for (const auto& field : headers) {
+    names += std::string(field.name()) + ";";
+  }
+  EXPECT_EQ(names, "Host;X-Custom;Accept;");
+  EXPECT_EQ(headers.size(), 3);
+}
+
+TEST(HeaderMapTest, RepeatedFields) {
+  HeaderMap headers{};
+  headers.add("Accept-Encoding", "gzip");
+  headers.add("accept-encoding", "br");
+  headers.add("X-Tag", "a");
+  headers.add("x-tag", "b");
+  headers.add("Set-Cookie", "a=1");
+  headers.add("Set-Cookie", "b=2");
+
+  EXPECT_EQ(headers.at(HeaderId::accept_encoding), "gzip, br");
+  EXPECT_EQ(headers.at("X-Tag"), "a, b");
+  EXPECT_EQ(headers.at(HeaderId::set_cookie), "a=1");
+  EXPECT_EQ(headers.size(), 4);
+}
+
+TEST(HeaderMapTest, SetAndErase) {
+  HeaderMap headers{};
+  headers.set(HeaderId::content_type, "text/plain");
+  headers.set("content-type", "text/html");
+  headers.set("X-A", "1");
+  headers.set("x-a", "2");
+  headers.add("Set-Cookie", "a=1");
+  headers.add("Set-Cookie", "b=2");
+  headers.set(HeaderId::vary, "Accept-Encoding");
+  EXPECT_EQ(headers.size(), 5);
+  EXPECT_EQ(headers.at(HeaderId::content_type), "text/html");
+  EXPECT_EQ(headers.at("X-A"), "2");
+
+  EXPECT_TRUE(headers.erase("set-cookie"));
+  EXPECT_FALSE(headers.erase("Set-Cookie"));
+  EXPECT_TRUE(headers.erase("X-A"));
+  EXPECT_EQ(headers.size(), 2);
+  // The index follows the fields that moved.
+  EXPECT_EQ(headers.at(HeaderId::vary), "Accept-Encoding");
+  EXPECT_EQ(headers.at(HeaderId::content_type), "text/html");
+
+  headers.clear();
+  EXPECT_TRUE(headers.empty());
+  EXPECT_FALSE(headers.contains(HeaderId::vary));
+}
+
+TEST(HeaderMapTest, Views) {
+  std::string received = "X-Tag: a\r\nx-tag: b\r\nHost: localhost\r\n";
+  std::string_view bytes{received};
+  auto copy = std::make_unique<HeaderViewMap>();
+  {
+    HeaderViewMap headers{};
+    headers.add(bytes.substr(0, 5), bytes.substr(7, 1));
+    headers.add(bytes.substr(10, 5), bytes.substr(17, 1));
+    headers.add(bytes.substr(20, 4), bytes.substr(26, 9));
+
+    // Values are not copied out of the received bytes.
+    EXPECT_EQ(headers.at(HeaderId::host), "localhost");
+    EXPECT_EQ(headers.at(HeaderId::host).data(), received.data() + 26);
+    EXPECT_EQ(headers.begin()->name().data(), received.data());
+    // Repeated fields are combined into storage the map shares with its copies.
+    EXPECT_EQ(headers.at("X-Tag"), "a, b");
+    *copy = headers;
+  }
+  EXPECT_EQ(copy->at("x-tag"), "a, b");
+  EXPECT_EQ(copy->size(), 2);
+}
@@ -11,14 +11,20 @@ public:
   MockAsioSocket(const MockAsioSocket&) = delete;
   MockAsioSocket(MockAsioSocket&&) = default;
 
-  void async_write_some(const boost::asio::const_buffers_1& buffer,
-                        std::function<void(boost::system::error_code, std::size_t)> callback);
+  template <typename ConstBufferSequence, typename WriteHandler>
+  void async_write_some(const ConstBufferSequence& buffers, WriteHandler&& callback) {
+    std::string write(boost::asio::buffers_begin(buffers), boost::asio::buffers_end(buffers));
+    m_write += write;
+    ++m_write_count;
+    callback(boost::system::error_code{}, write.size());
+  }
 
   void async_read_some(const boost::asio::mutable_buffers_1& buffer,
                        std::function<void(boost::system::error_code, std::size_t)> callback);
 
   const std::string& get_write() const { return m_write; }
   std::string& get_write() { return m_write; }
+  std::size_t get_write_count() const { return m_write_count; }
 
   bool is_open() const { return m_is_open; }
   void shutdown(boost::asio::ip::tcp::socket::shutdown_type type) { m_is_open = false; }
@@ -31,9 +37,10 @@ public:
 
 private:
   bool m_is_open = true;
-  bool m_is_read = false;
+  std::size_t m_read_offset = 0;
   std::string m_read;
   std::string m_write{};
+  std::size_t m_write_count = 0;
 };
 
 #endif // MOCK_SOCKET_H
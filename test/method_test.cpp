@@ -0,0 +1,26 @@
+#include "../include/method.hpp"
+
+#include <gtest/gtest.h>
+
+using web_server::message::Method;
+using web_server::message::METHOD_NAMES;
+using web_server::message::method_name;
+using web_server::message::parse_method;
+
+TEST(MethodTest, RoundTrip) {
+  for (std::size_t i = 0; i < METHOD_NAMES.size(); ++i) {
+    auto method = static_cast<Method>(i);
+    ASSERT_EQ(parse_method(method_name(method)), method) << METHOD_NAMES[i];
+  }
+  EXPECT_EQ(method_name(Method::DELETE), "DELETE");
+}
+
+TEST(MethodTest, Unknown) {
+  EXPECT_EQ(parse_method(""), std::nullopt);
+  EXPECT_EQ(parse_method("get"), std::nullopt);
+  EXPECT_EQ(parse_method("GE"), std::nullopt);
+  EXPECT_EQ(parse_method("GETS"), std::nullopt);
+  EXPECT_EQ(parse_method("BREW"), std::nullopt);
+  EXPECT_EQ(parse_method("OPTIONSS"), std::nullopt);
+  EXPECT_EQ(parse_method(std::string_view("GET\0", 4)), std::nullopt);
+}
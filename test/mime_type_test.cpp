@@ -0,0 +1,34 @@
+#include "../include/mime_type.hpp"
+
+#include <gtest/gtest.h>
+
+using web_server::message::DEFAULT_MIME_TYPE;
+using web_server::message::is_compressible;
+using web_server::message::mime_type;
+
+TEST(MimeTypeTest, Extension) {
+  EXPECT_EQ(mime_type("/www/index.html"), "text/html");
+  EXPECT_EQ(mime_type("/www/app.JS"), "text/javascript");
+  EXPECT_EQ(mime_type("style.min.css"), "text/css");
+  EXPECT_EQ(mime_type("/www/logo.svg"), "image/svg+xml");
+  EXPECT_EQ(mime_type("/www/photo.jpeg"), "image/jpeg");
+  EXPECT_EQ(mime_type("/www/font.woff2"), "font/woff2");
+}
+
+TEST(MimeTypeTest, Unknown) {
+  EXPECT_EQ(mime_type("/www/README"), DEFAULT_MIME_TYPE);
+  EXPECT_EQ(mime_type("/www/data.unknown"), DEFAULT_MIME_TYPE);
+  EXPECT_EQ(mime_type("/www.d/README"), DEFAULT_MIME_TYPE);
+  EXPECT_EQ(mime_type("/www/trailing."), DEFAULT_MIME_TYPE);
+  EXPECT_EQ(mime_type("/www/file.averyveryverylongextension"), DEFAULT_MIME_TYPE);
+}
+
+TEST(MimeTypeTest, Compressible) {
+  EXPECT_TRUE(is_compressible("text/html"));
+  EXPECT_TRUE(is_compressible("text/javascript"));
+  EXPECT_TRUE(is_compressible("application/json"));
+  EXPECT_TRUE(is_compressible("image/svg+xml"));
+  EXPECT_FALSE(is_compressible("image/png"));
+  EXPECT_FALSE(is_compressible("font/woff2"));
+  EXPECT_FALSE(is_compressible(DEFAULT_MIME_TYPE));
+}
@@ -1,19 +1,16 @@
 #include "include/mock_socket.hpp"
 
-void MockAsioSocket::async_write_some(
-    const boost::asio::const_buffers_1& buffer,
-    std::function<void(boost::system::error_code, std::size_t)> callback) {
-  m_write = std::string(boost::asio::buffers_begin(buffer), boost::asio::buffers_end(buffer));
-  callback(boost::system::error_code{}, m_write.size());
-}
+#include <algorithm>
 
 void MockAsioSocket::async_read_some(
     const boost::asio::mutable_buffers_1& buffer,
     std::function<void(boost::system::error_code, std::size_t)> callback) {
-  if (!m_is_read) {
-    m_is_read = true;
-    std::copy(m_read.begin(), m_read.end(), boost::asio::buffers_begin(buffer));
-    callback(boost::system::error_code{}, m_read.size());
+  // Hands out as much as fits into the buffer, then end of file.
+  if (m_read_offset < m_read.size()) {
+    auto size = std::min(buffer.size(), m_read.size() - m_read_offset);
+    std::copy_n(m_read.begin() + m_read_offset, size, boost::asio::buffers_begin(buffer));
+    m_read_offset += size;
+    callback(boost::system::error_code{}, size);
   } else {
     callback(boost::asio::error::eof, 0);
   }
@@ -43,6 +43,15 @@ TEST_F(RequestHeaderTest, Parse) {
   EXPECT_EQ(header.get("Accept-Encoding"), "gzip, deflate, br");
   EXPECT_TRUE(header.contain("Accept-Language"));
   EXPECT_EQ(header.get("Accept-Language"), "en-US,en;q=0.9");
+
+  // Field names are case-insensitive.
+  EXPECT_TRUE(header.contain("host"));
+  EXPECT_EQ(header.get("USER-AGENT").substr(0, 11), "Mozilla/5.0");
+  EXPECT_EQ(header.get("sec-fetch-dest"), "document");
+  EXPECT_FALSE(header.contain("Content-Length"));
+
+  // Values point into the parsed bytes.
+  EXPECT_EQ(header.get("Host").data(), reinterpret_cast<const char*>(data.data()) + 22);
 }
 
 TEST_F(RequestHeaderTest, ToBytes) {
@@ -0,0 +1,133 @@
+#include "../include/request_parser.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+
+using web_server::message::Method;
+using web_server::message::RequestParser;
+using Status = RequestParser::Status;
+using Error = RequestParser::Error;
+
+namespace {
+
+const std::string REQUEST = "GET /index.html?q=1 HTTP/1.1\r\n"
+                            "Host: localhost:8080\r\n"
+                            "Accept-Encoding:gzip, br  \r\n"
+                            "X-Empty:\r\n"
+                            "User-Agent: curl/8.0\r\n"
+                            "\r\n";
+
+Error parse_error(const std::string& request, std::size_t max_request_line = 1024,
+                  std::size_t max_header_size = 4096) {
+  RequestParser parser{max_request_line, max_header_size};
+  EXPECT_EQ(parser.parse(request), Status::error) << request;
+  return parser.error();
+}
+
+} // namespace
+
+TEST(RequestParserTest, Parse) {
+  RequestParser parser{};
+  std::string request = REQUEST + "body";
+  ASSERT_EQ(parser.parse(request), Status::complete);
+  EXPECT_EQ(parser.header_size(), REQUEST.size());
+  EXPECT_EQ(parser.method(), Method::GET);
+  EXPECT_EQ(parser.target(), "/index.html?q=1");
+  EXPECT_EQ(parser.version(), "HTTP/1.1");
+  ASSERT_EQ(parser.field_count(), 4);
+  EXPECT_EQ(parser.field(0).name, "Host");
+  EXPECT_EQ(parser.field(0).value, "localhost:8080");
+  EXPECT_EQ(parser.field(1).value, "gzip, br");
+  EXPECT_EQ(parser.field(2).name, "X-Empty");
+  EXPECT_EQ(parser.field(2).value, "");
+
+  EXPECT_EQ(parser.find("user-agent"), "curl/8.0");
+  EXPECT_EQ(parser.find("ACCEPT-ENCODING"), "gzip, br");
+  EXPECT_FALSE(parser.find("Cookie"));
+}
+
+TEST(RequestParserTest, Incremental) {
+  // Fed a byte at a time, from a buffer that moves with every call.
+  RequestParser parser{};
+  std::string buffer{};
+  for (std::size_t i = 0; i + 1 < REQUEST.size(); ++i) {
+    std::string moved = buffer + REQUEST[i];
+    buffer = std::move(moved);
+    ASSERT_EQ(parser.parse(buffer), Status::incomplete) << i;
+  }
+  buffer += REQUEST.back();
+  ASSERT_EQ(parser.parse(buffer), Status::complete);
+  EXPECT_EQ(parser.header_size(), REQUEST.size());
+  EXPECT_EQ(parser.target(), "/index.html?q=1");
+  EXPECT_EQ(parser.find("Host"), "localhost:8080");
+
+  // Complete stays complete, and the views follow the latest buffer.
+  std::string copy = buffer + "next";
+  EXPECT_EQ(parser.parse(copy), Status::complete);
+  EXPECT_EQ(parser.target().data(), copy.data() + 4);
+
+  parser.reset();
+  EXPECT_EQ(parser.parse("POST / HTTP/1.0\r\n\r\n"), Status::complete);
+  EXPECT_EQ(parser.method(), Method::POST);
+  EXPECT_EQ(parser.field_count(), 0);
+}
+
+TEST(RequestParserTest, LeadingEmptyLines) {
+  RequestParser parser{};
+  ASSERT_EQ(parser.parse("\r\n\r\nHEAD / HTTP/1.1\r\n\r\n"), Status::complete);
+  EXPECT_EQ(parser.method(), Method::HEAD);
+  EXPECT_EQ(parser.header_size(), 23);
+}
+
+TEST(RequestParserTest, BadRequest) {
+  EXPECT_EQ(parse_error(" / HTTP/1.1\r\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET  HTTP/1.1\r\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET /\r\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET / HTTP/1.1 \r\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET / HTTP/1.1\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET / HTTX/1.1\r\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET / HTTP/11\r\n\r\n"), Error::bad_request);
+  // Whitespace before the colon, obsolete line folding, control bytes.
+  EXPECT_EQ(parse_error("GET / HTTP/1.1\r\nHost : a\r\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET / HTTP/1.1\r\nHost: a\r\n b\r\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET / HTTP/1.1\r\nHost: a\x01\r\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET / HTTP/1.1\r\nHost\r\n\r\n"), Error::bad_request);
+  EXPECT_EQ(parse_error("GET / HTTP/1.1\r\n\rX"), Error::bad_request);
+
+  RequestParser parser{};
+  EXPECT_EQ(parser.parse("GET /\x7f HTTP/1.1\r\n\r\n"), Status::error);
+  EXPECT_EQ(parser.error_status_code(), 400);
+}
+
+TEST(RequestParserTest, Limits) {
+  std::string line = "GET /" + std::string(100, 'a') + " HTTP/1.1\r\n";
+  EXPECT_EQ(parse_error(line + "\r\n", 64), Error::uri_too_long);
+  // Known to be too long before the line ends.
+  EXPECT_EQ(parse_error(line.substr(0, 70), 64), Error::uri_too_long);
+  EXPECT_EQ(parse_error(line.substr(0, 70), 1024, 64), Error::header_fields_too_large);
+
+  std::string header = "GET / HTTP/1.1\r\n";
+  while (header.size() < 200) {
+    header += "X-Filler: 0123456789\r\n";
+  }
+  EXPECT_EQ(parse_error(header, 1024, 200), Error::header_fields_too_large);
+  EXPECT_EQ(parse_error(header + "\r\n", 1024, 200), Error::header_fields_too_large);
+
+  std::string fields = "GET / HTTP/1.1\r\n";
+  for (std::size_t i = 0; i <= RequestParser::MAX_FIELDS; ++i) {
+    fields += "X: " + std::to_string(i) + "\r\n";
+  }
+  EXPECT_EQ(parse_error(fields + "\r\n", 1024, 1 << 20), Error::header_fields_too_large);
+}
+
+TEST(RequestParserTest, UnsupportedMethodAndVersion) {
+  EXPECT_EQ(parse_error("BREW /pot HTTP/1.1\r\n\r\n"), Error::not_implemented);
+  EXPECT_EQ(parse_error("get / HTTP/1.1\r\n\r\n"), Error::not_implemented);
+  EXPECT_EQ(parse_error("GET / HTTP/2.0\r\n\r\n"), Error::version_not_supported);
+
+  RequestParser parser{};
+  ASSERT_EQ(parser.parse("GET / HTTP/1.9\r\n\r\n"), Status::complete);
+  parser.reset();
+  EXPECT_EQ(parser.parse("BREW /pot HTTP/1.1\r\n\r\n"), Status::error);
+  EXPECT_EQ(parser.error_status_code(), 501);
+}
@@ -1,4 +1,5 @@
 #include "../include/request.hpp"
+#include "../include/request_parser.hpp"
 
 #include <gtest/gtest.h>
 
@@ -46,3 +47,44 @@ TEST_F(RequestTest, ToBytes) {
   request.to_bytes(request_str);
   EXPECT_EQ(data.size(), request_str.size());
 }
+
+TEST_F(RequestTest, ViewsBody) {
+  web_server::message::Request request(data);
+  EXPECT_EQ(reinterpret_cast<const std::uint8_t*>(request.body().data()),
+            data.data() + data.size() - 12);
+
+  auto body = request.retain_body();
+  data.clear();
+  EXPECT_EQ(body.to_string_view(), "Hello World!");
+}
+
+TEST_F(RequestTest, OwnsBody) {
+  auto received_body = data.data() + data.size() - 12;
+  web_server::message::Request request(std::move(data));
+  EXPECT_EQ(request.header().get("Content-Length"), "12");
+  EXPECT_EQ(request.body(), "Hello World!");
+  EXPECT_EQ(reinterpret_cast<const std::uint8_t*>(request.body().data()), received_body);
+
+  auto body = request.retain_body();
+  EXPECT_EQ(body.data(), reinterpret_cast<const std::uint8_t*>(request.body().data()));
+}
+
+TEST_F(RequestTest, FromParser) {
+  web_server::message::RequestParser parser{};
+  ASSERT_EQ(parser.parse(std::string_view(reinterpret_cast<const char*>(data.data()), data.size())),
+            web_server::message::RequestParser::Status::complete);
+  // The connection parses its read buffer, then hands over a copy of it.
+  web_server::message::Data copy(data);
+  copy.set_sequence(3);
+  auto received = reinterpret_cast<const char*>(copy.data());
+  web_server::message::Request request(std::move(copy), parser);
+  data.clear();
+
+  EXPECT_EQ(request.sequence(), 3);
+  EXPECT_EQ(request.header().method(), web_server::message::Method::POST);
+  EXPECT_EQ(request.header().path(), "/");
+  EXPECT_EQ(request.header().path().data(), received + 5);
+  EXPECT_EQ(request.header().get("Host"), "localhost:8080");
+  EXPECT_EQ(request.header().get("Host").data(), received + 23);
+  EXPECT_EQ(request.body(), "Hello World!");
+}
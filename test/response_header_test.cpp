@@ -25,6 +25,8 @@ TEST_F(ResponseHeaderTest, Parse) {
   ASSERT_EQ(header.get("Content-Type"), "text/html");
   ASSERT_TRUE(header.contain("Content-Length"));
   ASSERT_EQ(header.get("Content-Length"), "0");
+  ASSERT_TRUE(header.contain("content-length"));
+  ASSERT_EQ(header.get(web_server::message::HeaderId::content_type), "text/html");
 }
 
 TEST_F(ResponseHeaderTest, ToBytes) {
@@ -33,3 +35,25 @@ TEST_F(ResponseHeaderTest, ToBytes) {
   std::string bytes{};
   ASSERT_EQ(header.to_bytes(bytes), data.size());
 }
+
+TEST(ResponseHeaderWriteTest, StatusCode) {
+  web_server::message::ResponseHeader header{404};
+  ASSERT_EQ(header.status_code(), 404);
+  ASSERT_EQ(header.status_message(), "Not Found");
+  header.set("Content-Length", "0");
+  std::string bytes{};
+  ASSERT_EQ(header.to_bytes(bytes), header.size());
+  ASSERT_EQ(bytes, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+}
+
+TEST(ResponseHeaderWriteTest, CustomStatusLine) {
+  for (auto [code, message, line] :
+       {std::tuple{200u, "Okay", "HTTP/1.1 200 Okay\r\n"},
+        std::tuple{299u, "Fine", "HTTP/1.1 299 Fine\r\n"}}) {
+    web_server::message::ResponseHeader header{code, message};
+    header.set("A", "b");
+    std::string bytes(header.size(), '\0');
+    ASSERT_EQ(header.write(bytes.data()), bytes.size());
+    ASSERT_EQ(bytes, std::string(line) + "A: b\r\n\r\n");
+  }
+}
@@ -38,3 +38,27 @@ TEST_F(ResponseTest, ToBytes) {
 
   EXPECT_EQ(bytes.size(), data.size());
 }
+
+TEST_F(ResponseTest, ToPayload) {
+  web_server::message::Response response{web_server::message::Data(data)};
+  web_server::message::Payload payload{};
+  response.to_payload(payload);
+
+  ASSERT_EQ(payload.segments().size(), 2);
+  EXPECT_EQ(payload.size(), data.size());
+  const auto& body = std::get<web_server::message::Buffer>(payload.segments()[1]);
+  EXPECT_EQ(body.data(), reinterpret_cast<const std::uint8_t*>(response.body().data()));
+}
+
+TEST_F(ResponseTest, ToPayloadRetainsView) {
+  web_server::message::Response response(data);
+  EXPECT_EQ(reinterpret_cast<const std::uint8_t*>(response.body().data()),
+            data.data() + data.size() - 13);
+  web_server::message::Payload payload{};
+  response.to_payload(payload);
+  data.clear();
+
+  const auto& body = std::get<web_server::message::Buffer>(payload.segments()[1]);
+  EXPECT_TRUE(body.shared());
+  EXPECT_EQ(body.to_string_view(), "Hello, World!");
+}
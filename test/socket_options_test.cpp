@@ -0,0 +1,70 @@
+#include "../include/socket_options.hpp"
+
+#include <gtest/gtest.h>
+#include <netinet/tcp.h>
+
+using web_server::reactor::SocketOptions;
+using boost::asio::ip::tcp;
+
+class SocketOptionsTest: public ::testing::Test {
+protected:
+  SocketOptionsTest(): m_acceptor(m_io_context) {
+    m_acceptor.open(tcp::v4());
+    m_acceptor.bind(tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+  }
+
+  boost::asio::io_context m_io_context{};
+  tcp::acceptor m_acceptor;
+};
+
+TEST_F(SocketOptionsTest, Defaults) {
+  SocketOptions options{};
+  EXPECT_TRUE(options.no_delay);
+  options.apply(m_acceptor);
+
+  tcp::no_delay no_delay{};
+  m_acceptor.get_option(no_delay);
+  EXPECT_TRUE(no_delay.value());
+}
+
+TEST_F(SocketOptionsTest, Listener) {
+  SocketOptions options{};
+  options.receive_buffer = 64 * 1024;
+  options.send_buffer = 64 * 1024;
+#ifdef TCP_DEFER_ACCEPT
+  options.defer_accept = 1;
+#endif
+  options.apply(m_acceptor);
+  m_acceptor.listen();
+
+  // The kernel may round the sizes up but never grants less.
+  boost::asio::socket_base::receive_buffer_size receive_buffer{};
+  m_acceptor.get_option(receive_buffer);
+  EXPECT_GE(receive_buffer.value(), options.receive_buffer);
+  boost::asio::socket_base::send_buffer_size send_buffer{};
+  m_acceptor.get_option(send_buffer);
+  EXPECT_GE(send_buffer.value(), options.send_buffer);
+
+  auto description = options.describe(m_acceptor);
+  EXPECT_NE(description.find("TCP_NODELAY=1"), std::string::npos);
+  EXPECT_NE(description.find("SO_RCVBUF="), std::string::npos);
+#ifdef TCP_DEFER_ACCEPT
+  EXPECT_EQ(description.find("TCP_DEFER_ACCEPT=0"), std::string::npos);
+#endif
+}
+
+TEST_F(SocketOptionsTest, AcceptedSocket) {
+  SocketOptions options{};
+  options.quick_ack = true;
+  options.apply(m_acceptor);
+  m_acceptor.listen();
+
+  tcp::socket client{m_io_context};
+  client.connect(m_acceptor.local_endpoint());
+  auto socket = m_acceptor.accept();
+  options.apply(socket);
+
+  tcp::no_delay no_delay{};
+  socket.get_option(no_delay);
+  EXPECT_TRUE(no_delay.value());
+}
@@ -0,0 +1,85 @@
+#include "../include/static_server.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+class StaticServerTest: public ::testing::Test {
+protected:
+  void SetUp() override {
+    m_root = std::filesystem::temp_directory_path() / "static_server_test";
+    std::filesystem::remove_all(m_root);
+    std::filesystem::create_directories(m_root);
+    m_server = std::make_unique<web_server::StaticServer>(0, m_root, false, 1);
+  }
+  void TearDown() override { std::filesystem::remove_all(m_root); }
+
+  // Compressible and large enough to be compressed on the fly.
+  void write(const std::string& name, bool old) {
+    auto path = m_root / name;
+    std::ofstream(path, std::ios::binary) << std::string(4096, 'a');
+    if (old) {
+      std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() -
+                                                 std::chrono::seconds(10));
+    }
+  }
+
+  // The response header, from its memory segments.
+  std::string get(const std::string& path, const std::string& fields = "") {
+    std::string request =
+        "GET " + path + " HTTP/1.1\r\nAccept-Encoding: gzip\r\n" + fields + "\r\n";
+    web_server::message::Request parsed{web_server::message::Data(
+        reinterpret_cast<const std::uint8_t*>(request.data()), request.size(), 0)};
+    auto payload = m_server->implement_handle_request(0, parsed);
+    std::string bytes{};
+    for (const auto& segment : payload.segments()) {
+      if (auto buffer = std::get_if<web_server::message::Buffer>(&segment)) {
+        bytes += buffer->to_string_view();
+      }
+    }
+    return bytes.substr(0, bytes.find("\r\n\r\n") + 2);
+  }
+
+  static std::string field(const std::string& header, const std::string& name) {
+    auto start = header.find("\r\n" + name + ": ");
+    if (start == std::string::npos) {
+      return {};
+    }
+    start += name.size() + 4;
+    return header.substr(start, header.find("\r\n", start) - start);
+  }
+
+  std::filesystem::path m_root;
+  std::unique_ptr<web_server::StaticServer> m_server;
+};
+
+TEST_F(StaticServerTest, CompressedValidator) {
+  write("old.html", true);
+  ASSERT_TRUE(m_server->file_cache().enabled());
+  auto header = get("/old.html");
+  ASSERT_TRUE(header.starts_with("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ(field(header, "Content-Encoding"), "gzip");
+  auto tag = field(header, "ETag");
+  EXPECT_NE(tag.find("-gzip"), std::string::npos);
+
+  EXPECT_TRUE(get("/old.html", "If-None-Match: " + tag + "\r\n").starts_with("HTTP/1.1 304"));
+}
+
+// A file modified within the last second is not cached, so it cannot be
+// compressed either: the identity body goes out, and conditional requests
+// are answered against its tag, not the tag a compressed body would have.
+TEST_F(StaticServerTest, UncompressedFallbackValidator) {
+  write("new.html", false);
+  auto header = get("/new.html");
+  ASSERT_TRUE(header.starts_with("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ(field(header, "Content-Encoding"), "");
+  auto tag = field(header, "ETag");
+  ASSERT_FALSE(tag.empty());
+  EXPECT_EQ(tag.find("-gzip"), std::string::npos);
+
+  EXPECT_TRUE(get("/new.html", "If-None-Match: " + tag + "\r\n").starts_with("HTTP/1.1 304"));
+  auto gzip_tag = tag.substr(0, tag.size() - 1) + "-gzip\"";
+  EXPECT_TRUE(
+      get("/new.html", "If-None-Match: " + gzip_tag + "\r\n").starts_with("HTTP/1.1 200 OK"));
+}
@@ -0,0 +1,35 @@
+#include "../include/status_code.hpp"
+
+#include <gtest/gtest.h>
+
+using web_server::message::reason_phrase;
+using web_server::message::status_line;
+using web_server::message::STATUS_CODES;
+
+static_assert(status_line(200) == "HTTP/1.1 200 OK\r\n");
+static_assert(reason_phrase(404) == "Not Found");
+
+TEST(StatusCodeTest, StatusLine) {
+  EXPECT_EQ(status_line(100), "HTTP/1.1 100 Continue\r\n");
+  EXPECT_EQ(status_line(206), "HTTP/1.1 206 Partial Content\r\n");
+  EXPECT_EQ(status_line(416), "HTTP/1.1 416 Range Not Satisfiable\r\n");
+  EXPECT_EQ(status_line(511), "HTTP/1.1 511 Network Authentication Required\r\n");
+  for (const auto& status : STATUS_CODES) {
+    EXPECT_EQ(status_line(status.code),
+              "HTTP/1.1 " + std::to_string(status.code) + " " + std::string(status.reason) +
+                  "\r\n");
+  }
+}
+
+TEST(StatusCodeTest, Unregistered) {
+  for (std::uint32_t code : {0u, 99u, 199u, 306u, 418u, 599u, 600u, 1000u}) {
+    EXPECT_TRUE(status_line(code).empty()) << code;
+    EXPECT_TRUE(reason_phrase(code).empty()) << code;
+  }
+}
+
+TEST(StatusCodeTest, ReasonPhrase) {
+  EXPECT_EQ(reason_phrase(200), "OK");
+  EXPECT_EQ(reason_phrase(304), "Not Modified");
+  EXPECT_EQ(reason_phrase(505), "HTTP Version Not Supported");
+}
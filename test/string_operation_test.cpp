@@ -43,3 +43,49 @@ TEST(StringOperationTest, SplitHead) {
   ASSERT_EQ(key.compare("Content-Length"), 0);
   ASSERT_EQ(value.compare("0"), 0);
 }
+
+TEST(StringOperationTest, Trim) {
+  EXPECT_EQ(web_server::utils::trim(" \tgzip \t"), "gzip");
+  EXPECT_EQ(web_server::utils::trim("a b"), "a b");
+  EXPECT_EQ(web_server::utils::trim(" \t "), "");
+  EXPECT_EQ(web_server::utils::trim(""), "");
+}
+
+TEST(StringOperationTest, HttpDate) {
+  EXPECT_EQ(web_server::utils::http_date(784111777), "Sun, 06 Nov 1994 08:49:37 GMT");
+  EXPECT_EQ(web_server::utils::http_date(0), "Thu, 01 Jan 1970 00:00:00 GMT");
+}
+
+TEST(StringOperationTest, ParseHttpDate) {
+  std::time_t time = 0;
+  EXPECT_TRUE(web_server::utils::parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT", time));
+  EXPECT_EQ(time, 784111777);
+  EXPECT_FALSE(web_server::utils::parse_http_date("Sun, 06 Nov 1994 08:49:37", time));
+  EXPECT_FALSE(web_server::utils::parse_http_date("yesterday", time));
+}
+
+TEST(StringOperationTest, Malformed) {
+  // Nothing is read past the end of the data.
+  std::string_view data{"GET / HTTP/1.1\r\nHost: a", 23};
+  std::string_view line;
+  int start = 16;
+  EXPECT_EQ(web_server::utils::get_line(data, line, &start), -1);
+  EXPECT_EQ(start, 23);
+  EXPECT_EQ(web_server::utils::get_line(data, line, &start), -1);
+
+  std::vector<std::string_view> words;
+  web_server::utils::split_line("GET", words);
+  ASSERT_EQ(words.size(), 1);
+  EXPECT_EQ(words[0], "GET");
+  words.clear();
+  web_server::utils::split_line("GET /", words);
+  ASSERT_EQ(words.size(), 2);
+  EXPECT_EQ(words[1], "/");
+
+  std::string_view key, value;
+  web_server::utils::split_head("Host", key, value);
+  EXPECT_EQ(key, "Host");
+  EXPECT_TRUE(value.empty());
+  web_server::utils::split_head("Host:   ", key, value);
+  EXPECT_TRUE(value.empty());
+}
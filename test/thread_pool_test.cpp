@@ -0,0 +1,44 @@
+#include "../include/thread_pool.hpp"
+
+#include <atomic>
+#include <future>
+#include <gtest/gtest.h>
+
+TEST(ThreadPoolTest, TryPushTaskWatermarks) {
+  web_server::thread::ThreadPool pool{1};
+  pool.set_watermarks(4, 2);
+
+  // Block the only worker so queued tasks stay queued.
+  std::promise<void> release{};
+  auto released = release.get_future().share();
+  std::promise<void> started{};
+  EXPECT_TRUE(pool.try_push_task([&started, released]() {
+    started.set_value();
+    released.wait();
+  }));
+  started.get_future().wait();
+
+  std::atomic<int> done{0};
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(pool.try_push_task([&done]() { ++done; }));
+  }
+  EXPECT_EQ(pool.queued_tasks(), 4);
+  EXPECT_FALSE(pool.try_push_task([&done]() { ++done; }));
+
+  release.set_value();
+  pool.wait_for_tasks();
+  EXPECT_EQ(done, 4);
+  EXPECT_TRUE(pool.try_push_task([&done]() { ++done; }));
+  pool.wait_for_tasks();
+  EXPECT_EQ(done, 5);
+}
+
+TEST(ThreadPoolTest, Unbounded) {
+  web_server::thread::ThreadPool pool{1};
+  std::atomic<int> done{0};
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(pool.try_push_task([&done]() { ++done; }));
+  }
+  pool.wait_for_tasks();
+  EXPECT_EQ(done, 1000);
+}
@@ -0,0 +1,103 @@
+#include "../include/timing_wheel.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using web_server::reactor::TimingWheel;
+using namespace std::chrono_literals;
+
+class TimingWheelTest: public ::testing::Test {
+protected:
+  TimingWheelTest(): m_start(TimingWheel::Clock::now()), m_wheel(10ms, m_start) {}
+
+  // Advances the wheel to `elapsed` after the start and runs the expired callbacks.
+  std::size_t advance(TimingWheel::Clock::duration elapsed) {
+    std::vector<TimingWheel::Callback> expired{};
+    auto count = m_wheel.advance(m_start + elapsed, expired);
+    for (auto& callback : expired) {
+      callback();
+    }
+    return count;
+  }
+
+  TimingWheel::Clock::time_point m_start;
+  TimingWheel m_wheel;
+  std::vector<std::string> m_fired{};
+};
+
+TEST_F(TimingWheelTest, Expire) {
+  m_wheel.schedule(50ms, [this]() { m_fired.push_back("a"); });
+  m_wheel.schedule(20ms, [this]() { m_fired.push_back("b"); });
+  EXPECT_EQ(m_wheel.size(), 2);
+
+  EXPECT_EQ(advance(19ms), 0);
+  EXPECT_EQ(advance(30ms), 1);
+  EXPECT_EQ(m_fired, std::vector<std::string>({"b"}));
+  EXPECT_EQ(advance(60ms), 1);
+  EXPECT_EQ(m_fired, std::vector<std::string>({"b", "a"}));
+  EXPECT_TRUE(m_wheel.empty());
+}
+
+TEST_F(TimingWheelTest, NeverEarly) {
+  advance(15ms);
+  m_wheel.schedule(10ms, [this]() { m_fired.push_back("a"); });
+  EXPECT_EQ(advance(24ms), 0);
+  EXPECT_EQ(advance(35ms), 1);
+}
+
+TEST_F(TimingWheelTest, Cancel) {
+  auto a = m_wheel.schedule(30ms, [this]() { m_fired.push_back("a"); });
+  m_wheel.schedule(30ms, [this]() { m_fired.push_back("b"); });
+  EXPECT_TRUE(m_wheel.cancel(a));
+  EXPECT_FALSE(m_wheel.cancel(a));
+  EXPECT_FALSE(m_wheel.cancel(TimingWheel::INVALID_TIMER));
+
+  EXPECT_EQ(advance(100ms), 1);
+  EXPECT_EQ(m_fired, std::vector<std::string>({"b"}));
+
+  // The slot of a fired timer is reused under a new id.
+  auto c = m_wheel.schedule(30ms, [this]() { m_fired.push_back("c"); });
+  EXPECT_NE(c, a);
+  EXPECT_FALSE(m_wheel.cancel(a));
+  EXPECT_TRUE(m_wheel.cancel(c));
+}
+
+TEST_F(TimingWheelTest, Cascade) {
+  // 64 ticks per level: these land on levels 1, 2 and 3 and cascade down.
+  m_wheel.schedule(1s, [this]() { m_fired.push_back("1s"); });
+  m_wheel.schedule(100s, [this]() { m_fired.push_back("100s"); });
+  m_wheel.schedule(1h, [this]() { m_fired.push_back("1h"); });
+
+  EXPECT_EQ(advance(999ms), 0);
+  EXPECT_EQ(advance(1010ms), 1);
+  EXPECT_EQ(advance(99990ms), 0);
+  EXPECT_EQ(advance(100010ms), 1);
+  EXPECT_EQ(advance(3599990ms), 0);
+  EXPECT_EQ(advance(3600010ms), 1);
+  EXPECT_EQ(m_fired, std::vector<std::string>({"1s", "100s", "1h"}));
+}
+
+TEST_F(TimingWheelTest, ScheduleFromCallback) {
+  m_wheel.schedule(10ms, [this]() {
+    m_fired.push_back("a");
+    m_wheel.schedule(10ms, [this]() { m_fired.push_back("b"); });
+  });
+  EXPECT_EQ(advance(20ms), 1);
+  EXPECT_EQ(m_wheel.size(), 1);
+  EXPECT_EQ(advance(40ms), 1);
+  EXPECT_EQ(m_fired, std::vector<std::string>({"a", "b"}));
+}
+
+TEST_F(TimingWheelTest, ManyTimers) {
+  std::vector<TimingWheel::TimerId> ids{};
+  for (int i = 0; i < 10000; ++i) {
+    ids.push_back(m_wheel.schedule(std::chrono::milliseconds(i), []() {}));
+  }
+  for (std::size_t i = 0; i < ids.size(); i += 2) {
+    EXPECT_TRUE(m_wheel.cancel(ids[i]));
+  }
+  EXPECT_EQ(advance(5s), 2500);
+  EXPECT_EQ(advance(11s), 2500);
+  EXPECT_TRUE(m_wheel.empty());
+}
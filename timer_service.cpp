@@ -0,0 +1,70 @@
+#include "include/timer_service.hpp"
+
+namespace web_server {
+namespace reactor {
+
+TimerService::TimerService(boost::asio::io_context& io_context)
+    : boost::asio::execution_context::service(io_context), _wheel(TICK), _timer(io_context) {}
+
+TimerService::TimerId TimerService::schedule(Clock::duration timeout, Callback callback) {
+  std::scoped_lock<std::mutex> lock{_mutex};
+  if (_shutdown) {
+    return TimingWheel::INVALID_TIMER;
+  }
+  if (_wheel.empty()) {
+    // Catch the idle wheel up with the clock before measuring the timeout from it.
+    _wheel.advance(Clock::now(), _expired);
+  }
+  auto id = _wheel.schedule(timeout, std::move(callback));
+  arm();
+  return id;
+}
+
+void TimerService::cancel(TimerId id) {
+  std::scoped_lock<std::mutex> lock{_mutex};
+  _wheel.cancel(id);
+}
+
+std::size_t TimerService::size() const {
+  std::scoped_lock<std::mutex> lock{_mutex};
+  return _wheel.size();
+}
+
+void TimerService::shutdown() {
+  std::scoped_lock<std::mutex> lock{_mutex};
+  _shutdown = true;
+  _wheel.clear();
+  boost::system::error_code ec;
+  _timer.cancel(ec);
+}
+
+void TimerService::arm() {
+  if (_armed) {
+    return;
+  }
+  _armed = true;
+  _timer.expires_after(TICK);
+  _timer.async_wait(std::bind(&TimerService::handle_tick, this, std::placeholders::_1));
+}
+
+void TimerService::handle_tick(boost::system::error_code ec) {
+  std::vector<Callback> expired{};
+  {
+    std::scoped_lock<std::mutex> lock{_mutex};
+    _armed = false;
+    if (ec || _shutdown) {
+      return;
+    }
+    _wheel.advance(Clock::now(), _expired);
+    expired.swap(_expired);
+    if (!_wheel.empty()) {
+      arm();
+    }
+  }
+  for (auto& callback : expired) {
+    callback();
+  }
+}
+
+} // namespace reactor
+} // namespace web_server
@@ -0,0 +1,147 @@
+#include "include/timing_wheel.hpp"
+
+#include <algorithm>
+
+namespace web_server {
+namespace reactor {
+
+TimingWheel::TimingWheel(Clock::duration tick, Clock::time_point start)
+    : _tick(std::max(tick, Clock::duration(1))), _start(start) {
+  _slots.fill(NIL);
+}
+
+TimingWheel::TimerId TimingWheel::schedule(Clock::duration timeout, Callback callback) {
+  // Round up and add the part of the current tick that already elapsed.
+  auto ticks = static_cast<std::uint64_t>(std::max(timeout.count(), Clock::rep(0)) /
+                                          _tick.count()) +
+               1;
+
+  std::uint32_t index;
+  if (_free != NIL) {
+    index = _free;
+    _free = _timers[index].next;
+  } else {
+    index = static_cast<std::uint32_t>(_timers.size());
+    _timers.emplace_back();
+  }
+
+  auto& timer = _timers[index];
+  timer.callback = std::move(callback);
+  timer.expiry = _current_tick + std::min(ticks, MAX_TICKS);
+  place(index);
+  ++_size;
+  return (static_cast<TimerId>(timer.generation) << 32) | index;
+}
+
+bool TimingWheel::cancel(TimerId id) {
+  auto index = static_cast<std::uint32_t>(id);
+  auto generation = static_cast<std::uint32_t>(id >> 32);
+  if (index >= _timers.size() || _timers[index].generation != generation ||
+      _timers[index].slot == NIL) {
+    return false;
+  }
+  unlink(index);
+  release(index);
+  --_size;
+  return true;
+}
+
+std::size_t TimingWheel::advance(Clock::time_point now, std::vector<Callback>& expired) {
+  if (now < _start) {
+    return 0;
+  }
+  std::uint64_t target = (now - _start) / _tick;
+  if (_size == 0) {
+    // Expiries are absolute ticks, an empty wheel can jump ahead.
+    _current_tick = std::max(_current_tick, target);
+    return 0;
+  }
+
+  std::size_t count = 0;
+  while (_current_tick < target) {
+    ++_current_tick;
+    for (std::uint32_t level = 1; level < LEVELS; ++level) {
+      if ((_current_tick & ((1ull << (SLOT_BITS * level)) - 1)) != 0) {
+        break;
+      }
+      cascade(level);
+    }
+
+    auto& head = _slots[_current_tick & (SLOTS - 1)];
+    while (head != NIL) {
+      auto index = head;
+      unlink(index);
+      expired.emplace_back(std::move(_timers[index].callback));
+      release(index);
+      --_size;
+      ++count;
+    }
+  }
+  return count;
+}
+
+void TimingWheel::clear() {
+  _timers.clear();
+  _free = NIL;
+  _slots.fill(NIL);
+  _size = 0;
+}
+
+void TimingWheel::place(std::uint32_t index) {
+  auto& timer = _timers[index];
+  auto delta = timer.expiry > _current_tick ? timer.expiry - _current_tick : 0;
+  std::uint32_t level = 0;
+  while (level + 1 < LEVELS && delta >= (1ull << (SLOT_BITS * (level + 1)))) {
+    ++level;
+  }
+  auto slot = (timer.expiry >> (SLOT_BITS * level)) & (SLOTS - 1);
+  link(index, level * SLOTS + static_cast<std::uint32_t>(slot));
+}
+
+void TimingWheel::link(std::uint32_t index, std::uint32_t slot) {
+  auto& timer = _timers[index];
+  timer.slot = slot;
+  timer.prev = NIL;
+  timer.next = _slots[slot];
+  if (timer.next != NIL) {
+    _timers[timer.next].prev = index;
+  }
+  _slots[slot] = index;
+}
+
+void TimingWheel::unlink(std::uint32_t index) {
+  auto& timer = _timers[index];
+  if (timer.prev != NIL) {
+    _timers[timer.prev].next = timer.next;
+  } else {
+    _slots[timer.slot] = timer.next;
+  }
+  if (timer.next != NIL) {
+    _timers[timer.next].prev = timer.prev;
+  }
+  timer.slot = NIL;
+}
+
+void TimingWheel::release(std::uint32_t index) {
+  auto& timer = _timers[index];
+  timer.callback = nullptr;
+  if (++timer.generation == 0) {
+    timer.generation = 1;
+  }
+  timer.next = _free;
+  _free = index;
+}
+
+void TimingWheel::cascade(std::uint32_t level) {
+  auto slot = level * SLOTS + ((_current_tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+  auto index = _slots[slot];
+  _slots[slot] = NIL;
+  while (index != NIL) {
+    auto next = _timers[index].next;
+    place(index);
+    index = next;
+  }
+}
+
+} // namespace reactor
+} // namespace web_server
@@ -1,52 +1,71 @@
 #include "include/utils.hpp"
+#include "include/char_scan.hpp"
+
+#include <algorithm>
 
 namespace web_server {
 namespace utils {
 
 [[nodiscard]] int get_line(std::string_view data, std::string_view& line, int* start) {
-  int i = *start;
-  while (data[i] != '\r' && data[i + 1] != '\n') {
-    ++i;
+  auto begin = static_cast<std::size_t>(*start);
+  auto end = begin <= data.size() ? find_crlf(data, begin) : std::string_view::npos;
+  if (end == std::string_view::npos) {
+    *start = static_cast<int>(data.size());
+    return -1;
   }
 
-  if (i == *start) {
-    *start = i + 2;
+  *start = static_cast<int>(end + 2);
+  if (end == begin) {
     return -1;
   }
-
-  line = std::string_view(data.data() + *start, i - *start);
-  *start = i + 2;
+  line = data.substr(begin, end - begin);
   return 0;
 }
 
 void split_line(std::string_view line, std::vector<std::string_view>& words) {
-  int i = 0;
-  while (line[i] != ' ') {
-    ++i;
+  auto first = line.find(' ');
+  words.emplace_back(line.substr(0, first));
+  if (first == std::string_view::npos) {
+    return;
   }
 
-  words.emplace_back(line.data(), i);
-  int j = i + 1;
-  while (line[j] != ' ') {
-    ++j;
+  auto second = line.find(' ', first + 1);
+  words.emplace_back(line.substr(first + 1, second - std::min(second, first + 1)));
+  if (second == std::string_view::npos) {
+    return;
   }
-
-  words.emplace_back(line.data() + i + 1, j - i - 1);
-  words.emplace_back(line.data() + j + 1, line.size() - j - 1);
+  words.emplace_back(line.substr(second + 1));
 }
 
 void split_head(std::string_view line, std::string_view& key, std::string_view& value) {
-  int i = 0;
-  while (line[i] != ':') {
-    ++i;
+  auto colon = line.find(':');
+  key = line.substr(0, colon);
+  if (colon == std::string_view::npos) {
+    value = {};
+    return;
   }
 
-  key = std::string_view(line.data(), i);
-  i++;
-  while (line[i] == ' ') {
-    ++i;
+  auto begin = line.find_first_not_of(' ', colon + 1);
+  value = begin == std::string_view::npos ? std::string_view{} : line.substr(begin);
+}
+
+std::string http_date(std::time_t time) {
+  std::tm tm{};
+  ::gmtime_r(&time, &tm);
+  char buffer[32];
+  auto size = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  return std::string(buffer, size);
+}
+
+bool parse_http_date(std::string_view date, std::time_t& time) {
+  std::string value{date};
+  std::tm tm{};
+  auto end = ::strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  if (end == nullptr || *end != '\0') {
+    return false;
   }
-  value = std::string_view(line.data() + i, line.size() - i);
+  time = ::timegm(&tm);
+  return true;
 }
 
 } // namespace utils